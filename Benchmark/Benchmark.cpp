@@ -0,0 +1,1162 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <iomanip>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+#include <cstdio>
+#include <thread>
+#include <cstdint>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <unistd.h>
+#endif
+
+#include "OrderBook.h"
+#include "EventLog.h"
+#include "TextLog.h"
+#include "BookManager.h"
+#include "Pipeline.h"
+#include "BookImage.h"
+#include "BatchReplay.h"
+#include "FeedGenerator.h"
+
+// Every heap allocation of the process goes through these, so the memory benchmark can count them (new[] and delete[]
+// forward to them by default, only the few over-aligned objects of the pipeline go through the aligned forms uncounted)
+std::atomic<uint64_t> heapAllocations{ 0 };
+
+void* operator new(size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size != 0 ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+// The two sides are replaced together and match: GCC doesn't know the replaced operator new returns malloc memory, and
+// warns about the free of every delete it inlines (-Wmismatched-new-delete), so that warning is turned off for them only
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+// Resident memory of the process in bytes, 0 if it can't be read on this platform
+size_t residentMemory() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.WorkingSetSize;
+    }
+    return 0;
+#else
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0;
+    size_t residentPages = 0;
+    if (statm >> pages >> residentPages) {
+        return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+    return 0;
+#endif
+}
+
+// Measures how long a CANCEL takes depending on how many orders are resting at the same price.
+// The level is kept at a constant depth: every batch of timed cancels is followed by an untimed batch of NEW orders.
+void benchmarkCancelByQueueDepth() {
+    const std::vector<int> queueDepths = { 10, 100, 1000, 10000, 100000 };
+    const int cancelsPerDepth = 200000;
+
+    std::cout << "Cancel latency by queue depth (" << cancelsPerDepth << " cancels per depth)" << std::endl;
+    std::cout << std::setw(12) << "depth" << std::setw(16) << "ns/cancel" << std::endl;
+
+    for (int depth : queueDepths) {
+        // Never cancel more than half the level in one batch so the depth stays close to the target
+        const int batchSize = std::max(1, std::min(1000, depth / 2));
+        const int numberOfBatches = cancelsPerDepth / batchSize;
+        OrderBook orderbook;
+        std::mt19937_64 rng(42);
+        std::vector<int64_t> restingIds;
+        int64_t nextOrderId = 1;
+        int64_t timestamp = 1;
+
+        Order newOrder = { 0, 0, priceToTicks(100.0), 1, 0, Side::Buy, Category::New };
+        Order cancelOrder = { 0, 0, priceToTicks(100.0), 1, 0, Side::Buy, Category::Cancel };
+
+        for (int i = 0; i < depth; ++i) {
+            newOrder.timestamp = timestamp++;
+            newOrder.orderId = nextOrderId++;
+            orderbook.processOrder(newOrder, "SCH");
+            restingIds.push_back(newOrder.orderId);
+        }
+
+        std::chrono::nanoseconds elapsed(0);
+        for (int batch = 0; batch < numberOfBatches; ++batch) {
+            // Pick the orders to cancel up front so the timed loop only contains processOrder calls
+            std::vector<int64_t> toCancel;
+            for (int i = 0; i < batchSize; ++i) {
+                size_t pick = rng() % restingIds.size();
+                toCancel.push_back(restingIds[pick]);
+                restingIds[pick] = restingIds.back();
+                restingIds.pop_back();
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            for (int64_t orderId : toCancel) {
+                cancelOrder.timestamp = timestamp++;
+                cancelOrder.orderId = orderId;
+                orderbook.processOrder(cancelOrder, "SCH");
+            }
+            elapsed += std::chrono::steady_clock::now() - start;
+
+            // Refill the level back to its original depth
+            for (int i = 0; i < batchSize; ++i) {
+                newOrder.timestamp = timestamp++;
+                newOrder.orderId = nextOrderId++;
+                orderbook.processOrder(newOrder, "SCH");
+                restingIds.push_back(newOrder.orderId);
+            }
+        }
+
+        double nsPerCancel = static_cast<double>(elapsed.count()) / (static_cast<double>(batchSize) * numberOfBatches);
+        std::cout << std::setw(12) << depth << std::setw(16) << std::fixed << std::setprecision(1) << nsPerCancel << std::endl;
+    }
+}
+
+// Load every order of a log file in memory so the book benchmarks don't measure parsing
+std::vector<Order> loadOrders(const std::string& filePath, SymbolTable& symbols) {
+    std::vector<Order> orders;
+    TextLogReader file;
+    if (!file.open(filePath)) {
+        std::cerr << "Unable to open file " << filePath << std::endl;
+        return orders;
+    }
+    std::string_view line;
+    while (file.nextLine(line)) {
+        Order order;
+        if (parseOrderLine(line, order, symbols)) {
+            orders.push_back(order);
+        }
+    }
+    return orders;
+}
+
+std::vector<Order> loadOrders(const std::string& filePath) {
+    SymbolTable symbols;
+    return loadOrders(filePath, symbols);
+}
+
+// Replay the orders in a fresh book a few times and return the best time per order in nanoseconds
+template <typename Book>
+double replayOrders(const std::vector<Order>& orders, int repetitions) {
+    double best = 0;
+    for (int run = 0; run < repetitions; ++run) {
+        Book orderbook;
+        auto start = std::chrono::steady_clock::now();
+        for (const Order& order : orders) {
+            orderbook.processOrder(order, "SCH");
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        double nsPerOrder = elapsed.count() / static_cast<double>(orders.size());
+        if (run == 0 || nsPerOrder < best) {
+            best = nsPerOrder;
+        }
+    }
+    return best;
+}
+
+// Compares the map based order book with the ladder based one on real logs (SCH.log, SCS.log, ...)
+void benchmarkBookTypes(const std::vector<std::string>& filePaths) {
+    const int repetitions = 5;
+
+    std::cout << "processOrder time per order, best of " << repetitions << " replays" << std::endl;
+    std::cout << std::setw(20) << "log" << std::setw(12) << "orders" << std::setw(16) << "map ns/order" << std::setw(18) << "ladder ns/order" << std::setw(10) << "speedup"
+        << std::setw(16) << "flat ns/order" << std::endl;
+
+    for (const std::string& filePath : filePaths) {
+        std::vector<Order> orders = loadOrders(filePath);
+        if (orders.empty()) {
+            continue;
+        }
+        double mapTime = replayOrders<OrderBook>(orders, repetitions);
+        double ladderTime = replayOrders<LadderOrderBook>(orders, repetitions);
+        double flatTime = replayOrders<FlatOrderBook>(orders, repetitions);
+        std::cout << std::setw(20) << filePath << std::setw(12) << orders.size() << std::fixed << std::setprecision(1)
+            << std::setw(16) << mapTime << std::setw(18) << ladderTime << std::setw(9) << mapTime / ladderTime << "x" << std::setw(16) << flatTime << std::endl;
+    }
+}
+
+// Cost of taking and writing a snapshot after every order: replay without snapshots, then with the snapshot window covering
+// the whole log and the snapshots written to a file in the text and in the binary layout, in the text layout with the analytics columns
+// and delta encoded (with the size of the delta file against the text one)
+void benchmarkSnapshots(const std::vector<std::string>& filePaths) {
+    std::cout << "Ladder book time per order, with and without a snapshot after every order" << std::endl;
+    std::cout << std::setw(20) << "log" << std::setw(12) << "orders" << std::setw(16) << "no snapshot ns" << std::setw(16) << "text ns" << std::setw(16) << "binary ns"
+        << std::setw(18) << "analytics ns" << std::setw(12) << "delta ns" << std::setw(14) << "delta size" << std::endl;
+
+    const std::string snapshotFile = "benchmark_snapshots";
+    for (const std::string& filePath : filePaths) {
+        std::vector<Order> orders = loadOrders(filePath);
+        if (orders.empty()) {
+            continue;
+        }
+        double times[5];
+        uint64_t fileSizes[5] = {};
+        for (int run = 0; run < 5; ++run) {
+            SnapshotFormat format = run == 2 ? SnapshotFormat::Binary : run == 4 ? SnapshotFormat::Delta : SnapshotFormat::Text;
+            std::string fileName = snapshotFile + snapshotFileExtension(format);
+            std::chrono::duration<double, std::nano> elapsed;
+            {
+                SnapshotWriter snapshots(fileName, "SCH", format, SnapshotWriter::DEFAULT_BUFFER_SIZE, run == 3);
+                LadderOrderBook orderbook;
+                if (run > 0) {
+                    orderbook.setSnapshotWriter(&snapshots);
+                }
+                auto start = std::chrono::steady_clock::now();
+                for (const Order& order : orders) {
+                    orderbook.processOrder(order, "SCH", 0, INT64_MAX);
+                }
+                snapshots.flush();
+                elapsed = std::chrono::steady_clock::now() - start;
+            }
+            std::ifstream written(fileName, std::ios::binary | std::ios::ate);
+            fileSizes[run] = static_cast<uint64_t>(std::max<std::streamoff>(written.tellg(), 0));
+            written.close();
+            std::remove(fileName.c_str());
+            times[run] = elapsed.count() / static_cast<double>(orders.size());
+        }
+        std::cout << std::setw(20) << filePath << std::setw(12) << orders.size() << std::fixed << std::setprecision(1)
+            << std::setw(16) << times[0] << std::setw(16) << times[1] << std::setw(16) << times[2] << std::setw(18) << times[3] << std::setw(12) << times[4]
+            << std::setw(13) << static_cast<double>(fileSizes[1]) / static_cast<double>(std::max<uint64_t>(fileSizes[4], 1)) << "x" << std::endl;
+    }
+}
+
+// Compares replaying a text log (getline + parsing) with replaying the same log converted to the binary format (memory mapped)
+void benchmarkBinaryReplay(const std::vector<std::string>& filePaths) {
+    std::cout << "Replay time per order, text log vs binary log" << std::endl;
+    std::cout << std::setw(20) << "log" << std::setw(12) << "orders" << std::setw(16) << "text ns/order" << std::setw(18) << "binary ns/order" << std::setw(10) << "speedup" << std::endl;
+
+    for (const std::string& filePath : filePaths) {
+        std::string binFilePath = filePath + ".bin";
+        uint64_t orderCount = convertLogToBinary(filePath, binFilePath);
+        if (orderCount == 0) {
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        {
+            LadderOrderBook orderbook;
+            SymbolTable symbols;
+            TextLogReader file;
+            file.open(filePath);
+            std::string_view line;
+            while (file.nextLine(line)) {
+                Order order;
+                if (parseOrderLine(line, order, symbols)) {
+                    orderbook.processOrder(order, "SCH");
+                }
+            }
+        }
+        std::chrono::duration<double, std::nano> textTime = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        {
+            LadderOrderBook orderbook;
+            BinaryLogReader log;
+            if (log.open(binFilePath)) {
+                for (const Order& order : log) {
+                    orderbook.processOrder(order, "SCH");
+                }
+            }
+        }
+        std::chrono::duration<double, std::nano> binaryTime = std::chrono::steady_clock::now() - start;
+
+        std::remove(binFilePath.c_str());
+
+        double textNs = textTime.count() / static_cast<double>(orderCount);
+        double binaryNs = binaryTime.count() / static_cast<double>(orderCount);
+        std::cout << std::setw(20) << filePath << std::setw(12) << orderCount << std::fixed << std::setprecision(1)
+            << std::setw(16) << textNs << std::setw(18) << binaryNs << std::setw(9) << textNs / binaryNs << "x" << std::endl;
+    }
+}
+
+// Parse rate of the text logs: std::getline + std::istringstream (how the logs used to be read) vs the memory mapped in place parser
+void benchmarkParse(const std::vector<std::string>& filePaths) {
+    std::cout << "Text log parse rate (parsing only, no order book)" << std::endl;
+    std::cout << std::setw(20) << "log" << std::setw(12) << "lines" << std::setw(20) << "istream lines/s" << std::setw(14) << "istream GB/s"
+        << std::setw(20) << "mmap lines/s" << std::setw(14) << "mmap GB/s" << std::endl;
+
+    for (const std::string& filePath : filePaths) {
+        uint64_t lines = 0;
+        uint64_t bytes = 0;
+        int64_t checksum = 0; // keeps the compiler from optimizing the parsing away
+
+        auto start = std::chrono::steady_clock::now();
+        {
+            std::ifstream file(filePath);
+            std::string line;
+            while (std::getline(file, line)) {
+                std::istringstream iss(line);
+                int64_t timestamp, orderId;
+                std::string symbol, side, category;
+                double price;
+                int quantity;
+                if (iss >> timestamp >> orderId >> symbol >> side >> category >> price >> quantity) {
+                    checksum += orderId + quantity + priceToTicks(price) + (parseSide(side) == Side::Buy);
+                }
+                ++lines;
+                bytes += line.size() + 1;
+            }
+        }
+        std::chrono::duration<double> streamTime = std::chrono::steady_clock::now() - start;
+        if (lines == 0) {
+            continue;
+        }
+
+        start = std::chrono::steady_clock::now();
+        {
+            TextLogReader file;
+            SymbolTable symbols;
+            file.open(filePath);
+            std::string_view line;
+            Order order;
+            while (file.nextLine(line)) {
+                if (parseOrderLine(line, order, symbols)) {
+                    checksum -= order.orderId + order.quantity + order.price + (order.side == Side::Buy);
+                }
+            }
+        }
+        std::chrono::duration<double> mappedTime = std::chrono::steady_clock::now() - start;
+
+        std::cout << std::setw(20) << filePath << std::setw(12) << lines << std::fixed
+            << std::setw(20) << std::setprecision(0) << lines / streamTime.count() << std::setw(14) << std::setprecision(3) << bytes / streamTime.count() / 1e9
+            << std::setw(20) << std::setprecision(0) << lines / mappedTime.count() << std::setw(14) << std::setprecision(3) << bytes / mappedTime.count() / 1e9
+            << (checksum != 0 ? "  (parsers disagree!)" : "") << std::endl;
+    }
+}
+
+// Throughput of the multi symbol engine (BookManager) depending on the number of worker threads
+void benchmarkSymbolWorkers(const std::vector<std::string>& filePaths) {
+    const std::vector<size_t> workerCounts = { 1, 2, 4, 8 };
+    // No snapshot: every order is before the start time
+    const int64_t noSnapshotTime = INT64_MAX;
+
+    for (const std::string& filePath : filePaths) {
+        SymbolTable symbols;
+        std::vector<Order> orders = loadOrders(filePath, symbols);
+        if (orders.empty()) {
+            continue;
+        }
+        std::cout << "Multi symbol replay of " << filePath << " (" << orders.size() << " orders, " << symbols.size() << " symbols, "
+            << std::thread::hardware_concurrency() << " cores)" << std::endl;
+        std::cout << std::setw(12) << "workers" << std::setw(16) << "orders/s" << std::endl;
+
+        for (size_t workerCount : workerCounts) {
+            auto start = std::chrono::steady_clock::now();
+            {
+                BookManager<LadderOrderBook> manager(workerCount, noSnapshotTime, noSnapshotTime, 5, ""); // no snapshot file
+                for (const Order& order : orders) {
+                    manager.submit(order, symbols);
+                }
+                manager.finish();
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+            std::cout << std::setw(12) << workerCount << std::setw(16) << std::fixed << std::setprecision(0) << orders.size() / elapsed.count() << std::endl;
+        }
+    }
+}
+
+// Heap allocations and resident memory of a full replay, for both book types
+// The allocations of the second half of the replay show whether the book still allocates once it is warmed up
+template <typename Book>
+void measureReplayMemory(const char* bookName, const std::vector<Order>& orders) {
+    const std::string symbol = "SCH";
+
+    size_t residentBefore = residentMemory();
+    uint64_t allocationsBefore = heapAllocations.load();
+    uint64_t allocationsHalfway = allocationsBefore;
+    size_t residentAfter = 0;
+    {
+        Book orderbook;
+        for (size_t i = 0; i < orders.size(); ++i) {
+            if (i == orders.size() / 2) {
+                allocationsHalfway = heapAllocations.load();
+            }
+            orderbook.processOrder(orders[i], symbol);
+        }
+        residentAfter = residentMemory();
+    }
+    uint64_t allocationsAfter = heapAllocations.load();
+
+    std::cout << std::setw(10) << bookName << std::setw(16) << allocationsAfter - allocationsBefore << std::setw(20) << allocationsAfter - allocationsHalfway
+        << std::setw(14) << std::fixed << std::setprecision(1) << (static_cast<double>(residentAfter) - static_cast<double>(residentBefore)) / (1024 * 1024) << std::endl;
+}
+
+void benchmarkMemory(const std::vector<std::string>& filePaths) {
+    for (const std::string& filePath : filePaths) {
+        std::vector<Order> orders = loadOrders(filePath);
+        if (orders.empty()) {
+            continue;
+        }
+        std::cout << "Memory of a replay of " << filePath << " (" << orders.size() << " orders)" << std::endl;
+        std::cout << std::setw(10) << "book" << std::setw(16) << "allocations" << std::setw(20) << "second half allocs" << std::setw(14) << "RSS delta MB" << std::endl;
+        measureReplayMemory<OrderBook>("map", orders);
+        measureReplayMemory<LadderOrderBook>("ladder", orders);
+        measureReplayMemory<FlatOrderBook>("flat", orders);
+    }
+}
+
+// Feeds the latency benchmark runs on: a typical book, deep queues, a fast moving price, mostly cancels, many symbols
+std::vector<std::pair<std::string, FeedConfig>> latencyFeeds() {
+    std::vector<std::pair<std::string, FeedConfig>> feeds;
+    FeedConfig typical;
+    feeds.push_back({ "typical", typical });
+    FeedConfig deepQueues;
+    deepQueues.restingOrdersPerSide = 20000;
+    deepQueues.levelsPerSide = 5;
+    feeds.push_back({ "deep queues", deepQueues });
+    FeedConfig volatilePrice;
+    volatilePrice.volatility = 500000;
+    feeds.push_back({ "volatile", volatilePrice });
+    FeedConfig cancelHeavy;
+    cancelHeavy.cancelPercent = 55;
+    cancelHeavy.tradePercent = 5;
+    feeds.push_back({ "cancel heavy", cancelHeavy });
+    FeedConfig manySymbols;
+    manySymbols.symbolCount = 100;
+    manySymbols.restingOrdersPerSide = 100;
+    feeds.push_back({ "100 symbols", manySymbols });
+    return feeds;
+}
+
+// Time per order and latency percentiles of processOrder on a synthetic feed (one book per symbol)
+template <typename Book>
+void measureLatency(const char* bookName, const std::vector<Order>& orders, int symbolCount) {
+    const std::string symbol = "S";
+
+    // Throughput without the clock in the loop
+    double nsPerOrder = 0;
+    {
+        std::vector<Book> books(static_cast<size_t>(symbolCount));
+        auto start = std::chrono::steady_clock::now();
+        for (const Order& order : orders) {
+            books[order.symbol].processOrder(order, symbol);
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        nsPerOrder = elapsed.count() / static_cast<double>(orders.size());
+    }
+
+    // Latency of every order, the clock is read around each call
+    std::vector<int64_t> latencies(orders.size());
+    {
+        std::vector<Book> books(static_cast<size_t>(symbolCount));
+        for (size_t i = 0; i < orders.size(); ++i) {
+            auto start = std::chrono::steady_clock::now();
+            books[orders[i].symbol].processOrder(orders[i], symbol);
+            auto end = std::chrono::steady_clock::now();
+            latencies[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        }
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double fraction) {
+        return latencies[std::min(latencies.size() - 1, static_cast<size_t>(fraction * static_cast<double>(latencies.size())))];
+    };
+    std::cout << std::setw(10) << bookName << std::setw(14) << std::fixed << std::setprecision(1) << nsPerOrder
+        << std::setw(14) << std::setprecision(0) << 1e9 / nsPerOrder
+        << std::setw(10) << percentile(0.5) << std::setw(10) << percentile(0.99) << std::setw(10) << percentile(0.999) << std::setw(10) << latencies.back() << std::endl;
+}
+
+void benchmarkLatency() {
+    const size_t orderCount = 2000000;
+
+    // Cost of reading the clock, included in every latency below
+    std::vector<int64_t> clockCosts(100000);
+    for (int64_t& cost : clockCosts) {
+        auto start = std::chrono::steady_clock::now();
+        auto end = std::chrono::steady_clock::now();
+        cost = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    }
+    std::nth_element(clockCosts.begin(), clockCosts.begin() + clockCosts.size() / 2, clockCosts.end());
+    std::cout << "processOrder latency on synthetic feeds (" << orderCount << " orders each, clock overhead ~" << clockCosts[clockCosts.size() / 2] << " ns)" << std::endl;
+
+    for (const auto& feed : latencyFeeds()) {
+        FeedGenerator generator(feed.second);
+        std::vector<Order> orders = generator.generate(orderCount);
+        std::cout << feed.first << " (" << feed.second.symbolCount << " symbols, " << feed.second.restingOrdersPerSide << " orders per side on "
+            << feed.second.levelsPerSide << " levels, volatility " << feed.second.volatility << " ppm, " << 100 - feed.second.cancelPercent - feed.second.tradePercent
+            << "/" << feed.second.cancelPercent << "/" << feed.second.tradePercent << " new/cancel/trade)" << std::endl;
+        std::cout << std::setw(10) << "book" << std::setw(14) << "ns/order" << std::setw(14) << "orders/s" << std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns"
+            << std::setw(10) << "p99.9 ns" << std::setw(10) << "max ns" << std::endl;
+        measureLatency<OrderBook>("map", orders, feed.second.symbolCount);
+        measureLatency<LadderOrderBook>("ladder", orders, feed.second.symbolCount);
+        measureLatency<FlatOrderBook>("flat", orders, feed.second.symbolCount);
+    }
+}
+
+// Cycle counter ticks (the TSC on x86, see readCycleCounter) per processOrder call on a synthetic feed: the average over the
+// whole feed without anything else in the loop, then the median of each category with the counter read around every call
+// (minus the cost of reading it)
+template <typename Book>
+void measureCycles(const char* bookName, const std::vector<Order>& orders, int symbolCount, uint64_t counterOverhead) {
+    const std::string symbol = "S";
+
+    double cyclesPerOrder = 0;
+    {
+        std::vector<Book> books(static_cast<size_t>(symbolCount));
+        uint64_t start = readCycleCounter();
+        for (const Order& order : orders) {
+            books[order.symbol].processOrder(order, symbol);
+        }
+        cyclesPerOrder = static_cast<double>(readCycleCounter() - start) / static_cast<double>(orders.size());
+    }
+
+    std::vector<uint64_t> cycles[3]; // NEW, CANCEL, TRADE
+    {
+        std::vector<Book> books(static_cast<size_t>(symbolCount));
+        for (const Order& order : orders) {
+            uint64_t start = readCycleCounter();
+            books[order.symbol].processOrder(order, symbol);
+            uint64_t elapsed = readCycleCounter() - start;
+            size_t category = static_cast<size_t>(order.category);
+            if (category < 3) {
+                cycles[category].push_back(elapsed - std::min(elapsed, counterOverhead));
+            }
+        }
+    }
+
+    std::cout << std::setw(10) << bookName << std::setw(14) << std::fixed << std::setprecision(1) << cyclesPerOrder;
+    for (std::vector<uint64_t>& categoryCycles : cycles) {
+        if (categoryCycles.empty()) {
+            std::cout << std::setw(12) << "-";
+            continue;
+        }
+        std::nth_element(categoryCycles.begin(), categoryCycles.begin() + categoryCycles.size() / 2, categoryCycles.end());
+        std::cout << std::setw(12) << categoryCycles[categoryCycles.size() / 2];
+    }
+    std::cout << std::endl;
+}
+
+void benchmarkCycles() {
+    const size_t orderCount = 2000000;
+
+    // Cost of reading the counter twice in a row, taken off the per call counts
+    std::vector<uint64_t> counterCosts(100000);
+    for (uint64_t& cost : counterCosts) {
+        uint64_t start = readCycleCounter();
+        cost = readCycleCounter() - start;
+    }
+    std::nth_element(counterCosts.begin(), counterCosts.begin() + counterCosts.size() / 2, counterCosts.end());
+    uint64_t counterOverhead = counterCosts[counterCosts.size() / 2];
+    std::cout << "processOrder cycle counter ticks on synthetic feeds (" << orderCount << " orders each, " << cycleCounterTicksPerNanosecond()
+        << " ticks/ns, counter overhead ~" << counterOverhead << " ticks)" << std::endl;
+
+    for (const auto& feed : latencyFeeds()) {
+        FeedGenerator generator(feed.second);
+        std::vector<Order> orders = generator.generate(orderCount);
+        std::cout << feed.first << std::endl;
+        std::cout << std::setw(10) << "book" << std::setw(14) << "ticks/order" << std::setw(12) << "NEW p50" << std::setw(12) << "CANCEL p50" << std::setw(12) << "TRADE p50" << std::endl;
+        measureCycles<OrderBook>("map", orders, feed.second.symbolCount, counterOverhead);
+        measureCycles<LadderOrderBook>("ladder", orders, feed.second.symbolCount, counterOverhead);
+    }
+}
+
+// Hash of the levels and counts of a view (not of the padding of the levels)
+uint64_t hashDepthView(uint64_t updateCount, uint32_t bidCount, uint32_t askCount, const DepthLevel* bids, const DepthLevel* asks) {
+    uint64_t hash = 1469598103934665603ull;
+    auto mix = [&](uint64_t value) {
+        hash = (hash ^ value) * 1099511628211ull;
+    };
+    mix(updateCount);
+    mix(bidCount);
+    mix(askCount);
+    for (uint32_t i = 0; i < bidCount; ++i) {
+        mix(static_cast<uint64_t>(bids[i].price));
+        mix(static_cast<uint64_t>(bids[i].quantity));
+    }
+    for (uint32_t i = 0; i < askCount; ++i) {
+        mix(static_cast<uint64_t>(asks[i].price));
+        mix(static_cast<uint64_t>(asks[i].quantity));
+    }
+    return hash;
+}
+
+// Writer latency while reader threads read the published top of the book (BookView.h) as fast as they can, and a check that
+// no reader ever sees a torn view: every view read must be exactly the view published after the event it claims to be from
+// (its updateCount), the expected views are computed first on a single thread. The readers alternate full views and best bid/ask.
+void benchmarkConcurrentReaders() {
+    const size_t orderCount = 1000000;
+    FeedGenerator generator(FeedConfig{});
+    std::vector<Order> orders = generator.generate(orderCount);
+    const std::string symbol = "S";
+
+    std::vector<uint64_t> expectedViews(orders.size());
+    std::vector<uint64_t> expectedTops(orders.size());
+    {
+        LadderOrderBook orderbook;
+        PublishedDepth published;
+        orderbook.setDepthPublisher(&published);
+        for (size_t i = 0; i < orders.size(); ++i) {
+            orderbook.processOrder(orders[i], symbol);
+            DepthView view = published.read();
+            expectedViews[i] = hashDepthView(view.updateCount, view.bidCount, view.askCount, view.bids, view.asks);
+            expectedTops[i] = hashDepthView(view.updateCount, std::min(view.bidCount, 1u), std::min(view.askCount, 1u), view.bids, view.asks);
+        }
+    }
+
+    std::cout << "Ladder book writer latency with reader threads reading the published top " << PublishedDepth().levelCount() << " levels (" << orderCount
+        << " orders, " << std::thread::hardware_concurrency() << " hardware threads)" << std::endl;
+    std::cout << std::setw(10) << "readers" << std::setw(12) << "ns/order" << std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns" << std::setw(10) << "p99.9 ns"
+        << std::setw(10) << "max ns" << std::setw(16) << "reads/s" << std::setw(10) << "torn" << std::endl;
+    for (int readerCount : { 0, 1, 2, 4 }) {
+        LadderOrderBook orderbook;
+        PublishedDepth published;
+        orderbook.setDepthPublisher(&published);
+        std::atomic<bool> done{ false };
+        std::atomic<uint64_t> reads{ 0 };
+        std::atomic<uint64_t> tornViews{ 0 };
+        std::vector<std::thread> readers;
+        for (int reader = 0; reader < readerCount; ++reader) {
+            readers.emplace_back([&] {
+                uint64_t readCount = 0;
+                uint64_t torn = 0;
+                while (!done.load(std::memory_order_relaxed)) {
+                    if (readCount % 2 == 0) {
+                        DepthView view = published.read();
+                        if (view.updateCount > 0 && hashDepthView(view.updateCount, view.bidCount, view.askCount, view.bids, view.asks) != expectedViews[view.updateCount - 1]) {
+                            ++torn;
+                        }
+                    }
+                    else {
+                        TopOfBook top = published.readTopOfBook();
+                        if (top.updateCount > 0 && hashDepthView(top.updateCount, std::min(top.bidCount, 1u), std::min(top.askCount, 1u), &top.bestBid, &top.bestAsk) != expectedTops[top.updateCount - 1]) {
+                            ++torn;
+                        }
+                    }
+                    ++readCount;
+                }
+                reads += readCount;
+                tornViews += torn;
+            });
+        }
+
+        std::vector<int64_t> latencies(orders.size());
+        auto replayStart = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < orders.size(); ++i) {
+            auto start = std::chrono::steady_clock::now();
+            orderbook.processOrder(orders[i], symbol);
+            auto end = std::chrono::steady_clock::now();
+            latencies[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - replayStart;
+        done = true;
+        for (std::thread& reader : readers) {
+            reader.join();
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&](double fraction) {
+            return latencies[std::min(latencies.size() - 1, static_cast<size_t>(fraction * static_cast<double>(latencies.size())))];
+        };
+        std::cout << std::setw(10) << readerCount << std::setw(12) << std::fixed << std::setprecision(1) << elapsed.count() * 1e9 / static_cast<double>(orders.size())
+            << std::setw(10) << percentile(0.5) << std::setw(10) << percentile(0.99) << std::setw(10) << percentile(0.999) << std::setw(10) << latencies.back()
+            << std::setw(16) << std::setprecision(0) << static_cast<double>(reads.load()) / elapsed.count() << std::setw(10) << tornViews.load() << std::endl;
+    }
+}
+
+// Order flow of a simulation for the matching mode: passive NEW orders around a moving mid price, cancels of recent passive
+// orders (some of them already filled, those are rejected) and aggressive NEW orders priced through the opposite side.
+// Deterministic: only the raw output of std::mt19937_64 is used.
+std::vector<Order> generateMatchingFlow(size_t count, int aggressivePercent, uint64_t seed = 1) {
+    std::mt19937_64 rng(seed);
+    auto uniform = [&](uint64_t bound) {
+        return static_cast<int64_t>(rng() % bound);
+    };
+    const int64_t levels = 20;
+    const size_t recentCount = 2048;
+    std::vector<Order> recentPassive; // ring of the last passive orders, for the cancels
+    recentPassive.reserve(recentCount);
+    std::vector<Order> orders;
+    orders.reserve(count);
+    int64_t mid = 10670;
+    int64_t timestamp = 1609723800000000000;
+    int64_t nextOrderId = 1;
+    for (size_t i = 0; i < count; ++i) {
+        timestamp += 1 + uniform(1000);
+        if (uniform(100) < 2) {
+            mid += uniform(2) ? 1 : -1;
+        }
+        Side side = uniform(2) ? Side::Buy : Side::Sell;
+        int64_t roll = uniform(100);
+        if (roll < aggressivePercent) {
+            // Through the opposite side by up to `levels` ticks, so it usually sweeps a few levels
+            int64_t through = uniform(levels);
+            int64_t price = side == Side::Buy ? mid + through : mid - through;
+            orders.push_back({ timestamp, nextOrderId++, price, static_cast<int32_t>(1 + uniform(40)), 0, side, Category::New });
+        }
+        else if (roll < aggressivePercent + (100 - aggressivePercent) * 65 / 100 || recentPassive.empty()) {
+            int64_t distance = 1 + uniform(levels);
+            int64_t price = side == Side::Buy ? mid - distance : mid + distance;
+            orders.push_back({ timestamp, nextOrderId++, price, static_cast<int32_t>(1 + uniform(20)), 0, side, Category::New });
+            if (recentPassive.size() < recentCount) {
+                recentPassive.push_back(orders.back());
+            }
+            else {
+                recentPassive[static_cast<size_t>(orders.back().orderId) % recentCount] = orders.back();
+            }
+        }
+        else {
+            Order cancel = recentPassive[static_cast<size_t>(uniform(recentPassive.size()))];
+            cancel.timestamp = timestamp;
+            cancel.category = Category::Cancel;
+            orders.push_back(cancel);
+        }
+    }
+    return orders;
+}
+
+// Throughput of the matching mode (BasicOrderBook::setFillBuffer) depending on the share of aggressive orders, and the heap
+// allocations of the second half of the replay. The fills don't allocate (a buffer allocated once and cleared after every
+// order), the 2 or 3 left are the resting order pool and the orderId index doubling: the flow only cancels recent orders,
+// so the book still reaches new sizes in the second half.
+void benchmarkMatching() {
+    const size_t orderCount = 2000000;
+    const std::string symbol = "S";
+    std::cout << "Matching mode on a simulated order flow (" << orderCount << " orders, ladder book)" << std::endl;
+    std::cout << std::setw(12) << "aggressive" << std::setw(12) << "ns/order" << std::setw(14) << "orders/s" << std::setw(14) << "fills/order"
+        << std::setw(12) << "qty/fill" << std::setw(12) << "resting" << std::setw(20) << "allocs (2nd half)" << std::endl;
+    for (int aggressivePercent : { 10, 20, 30, 40, 50 }) {
+        std::vector<Order> orders = generateMatchingFlow(orderCount, aggressivePercent);
+        LadderOrderBook orderbook;
+        FillBuffer fills;
+        orderbook.setFillBuffer(&fills);
+        int64_t filledQuantity = 0;
+        uint64_t allocationsHalfway = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < orders.size(); ++i) {
+            if (i == orders.size() / 2) {
+                allocationsHalfway = heapAllocations.load();
+            }
+            orderbook.processOrder(orders[i], symbol);
+            for (const Fill& fill : fills) {
+                filledQuantity += fill.quantity;
+            }
+            fills.clear();
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        uint64_t allocations = heapAllocations.load() - allocationsHalfway;
+        size_t restingOrders = 0;
+        orderbook.forEachRestingOrder([&](const Order&, bool) {
+            ++restingOrders;
+        });
+        double nsPerOrder = elapsed.count() / static_cast<double>(orders.size());
+        std::cout << std::setw(11) << aggressivePercent << "%" << std::setw(12) << std::fixed << std::setprecision(1) << nsPerOrder
+            << std::setw(14) << std::setprecision(0) << 1e9 / nsPerOrder << std::setw(14) << std::setprecision(2) << static_cast<double>(fills.totalFills()) / static_cast<double>(orders.size())
+            << std::setw(12) << static_cast<double>(filledQuantity) / static_cast<double>(std::max<uint64_t>(fills.totalFills(), 1))
+            << std::setw(12) << restingOrders << std::setw(20) << allocations << std::endl;
+    }
+}
+
+// Warm start from a book image (see BookImage.h) against replaying the log up to the same point, on a deep synthetic book:
+// the first half of the feed is replayed and saved, the image restored in an empty book, then both books process the second
+// half and must stay identical (top of the book after every order, every resting order at the end)
+template <typename Book>
+void measureBookImage(const char* bookName, const std::vector<Order>& orders) {
+    const std::string symbol = "S";
+    const std::string imagePath = "benchmark_book.image";
+    size_t half = orders.size() / 2;
+
+    Book replayed;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < half; ++i) {
+        replayed.processOrder(orders[i], symbol);
+    }
+    std::chrono::duration<double, std::milli> replayElapsed = std::chrono::steady_clock::now() - start;
+
+    BookImageHeader header = {};
+    start = std::chrono::steady_clock::now();
+    writeBookImage(replayed, header, imagePath);
+    std::chrono::duration<double, std::milli> saveElapsed = std::chrono::steady_clock::now() - start;
+
+    Book restored;
+    start = std::chrono::steady_clock::now();
+    BookImageReader image;
+    if (!image.open(imagePath)) {
+        return;
+    }
+    image.restore(restored);
+    std::chrono::duration<double, std::milli> restoreElapsed = std::chrono::steady_clock::now() - start;
+    uint64_t restingOrders = image.getHeader().orderCount;
+    uint64_t levels = image.getHeader().bidLevelCount + image.getHeader().askLevelCount;
+
+    auto sameLevels = [](const std::vector<DepthLevel>& a, const std::vector<DepthLevel>& b) {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const DepthLevel& x, const DepthLevel& y) {
+            return x.price == y.price && x.quantity == y.quantity;
+        });
+    };
+    bool identical = true;
+    for (size_t i = half; i < orders.size() && identical; ++i) {
+        replayed.processOrder(orders[i], symbol);
+        restored.processOrder(orders[i], symbol);
+        identical = sameLevels(replayed.getTopBids(SNAPSHOT_DEPTH), restored.getTopBids(SNAPSHOT_DEPTH))
+            && sameLevels(replayed.getTopAsks(SNAPSHOT_DEPTH), restored.getTopAsks(SNAPSHOT_DEPTH));
+    }
+    std::vector<std::pair<Order, bool>> replayedOrders;
+    std::vector<std::pair<Order, bool>> restoredOrders;
+    replayed.forEachRestingOrder([&](const Order& order, bool indexed) {
+        replayedOrders.push_back({ order, indexed });
+    });
+    restored.forEachRestingOrder([&](const Order& order, bool indexed) {
+        restoredOrders.push_back({ order, indexed });
+    });
+    identical = identical && std::equal(replayedOrders.begin(), replayedOrders.end(), restoredOrders.begin(), restoredOrders.end(),
+        [](const std::pair<Order, bool>& a, const std::pair<Order, bool>& b) {
+            return a.first.orderId == b.first.orderId && a.first.side == b.first.side && a.first.price == b.first.price
+                && a.first.quantity == b.first.quantity && a.second == b.second;
+        });
+    std::remove(imagePath.c_str());
+
+    std::cout << std::setw(10) << bookName << std::setw(12) << restingOrders << std::setw(10) << levels << std::setw(14) << std::fixed << std::setprecision(1)
+        << replayElapsed.count() << std::setw(12) << saveElapsed.count() << std::setw(14) << restoreElapsed.count()
+        << std::setw(12) << replayElapsed.count() / std::max(restoreElapsed.count(), 1e-3) << "x" << std::setw(12) << (identical ? "yes" : "NO") << std::endl;
+}
+
+void benchmarkBookImage() {
+    const size_t orderCount = 4000000;
+    FeedConfig deepBook;
+    deepBook.restingOrdersPerSide = 200000;
+    deepBook.levelsPerSide = 50;
+    FeedGenerator generator(deepBook);
+    std::vector<Order> orders = generator.generate(orderCount);
+    std::cout << "Book image restore vs replay of the first " << orderCount / 2 << " orders of a deep synthetic feed" << std::endl;
+    std::cout << std::setw(10) << "book" << std::setw(12) << "orders" << std::setw(10) << "levels" << std::setw(14) << "replay ms"
+        << std::setw(12) << "save ms" << std::setw(14) << "restore ms" << std::setw(13) << "speedup" << std::setw(12) << "identical" << std::endl;
+    measureBookImage<OrderBook>("map", orders);
+    measureBookImage<LadderOrderBook>("ladder", orders);
+}
+
+// End to end replay of generated logs, the same work as ReadTextFile: memory mapped file, parsing, order book, last snapshot written
+void benchmarkReplay(const std::vector<uint64_t>& lineCounts) {
+    std::cout << "End to end replay of generated logs (ladder book)" << std::endl;
+    std::cout << std::setw(14) << "lines" << std::setw(12) << "MB" << std::setw(12) << "seconds" << std::setw(16) << "lines/s" << std::setw(10) << "GB/s" << std::endl;
+
+    for (uint64_t lineCount : lineCounts) {
+        std::string filePath = "benchmark_" + std::to_string(lineCount) + ".log";
+        uint64_t bytes = writeFeedLog(filePath, FeedConfig(), lineCount);
+        if (bytes == 0) {
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        {
+            const std::string symbol = FeedGenerator::symbolName(0);
+            LadderOrderBook orderbook;
+            SnapshotWriter snapshots("benchmark_snapshots.txt", symbol);
+            SymbolTable symbols;
+            uint16_t symbolId = symbols.intern(symbol);
+            TextLogReader file;
+            file.open(filePath);
+            std::string_view line;
+            int64_t lastTimestamp = 0;
+            while (file.nextLine(line)) {
+                Order order;
+                if (parseOrderLine(line, order, symbols) && order.symbol == symbolId) {
+                    orderbook.processOrder(order, symbol);
+                    lastTimestamp = order.timestamp;
+                }
+            }
+            orderbook.setSnapshotWriter(&snapshots);
+            orderbook.takeSnapshot(lastTimestamp, symbol);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::remove(filePath.c_str());
+        std::remove("benchmark_snapshots.txt");
+
+        std::cout << std::setw(14) << lineCount << std::setw(12) << std::fixed << std::setprecision(0) << bytes / 1e6 << std::setw(12) << std::setprecision(2) << elapsed.count()
+            << std::setw(16) << std::setprecision(0) << lineCount / elapsed.count() << std::setw(10) << std::setprecision(3) << bytes / elapsed.count() / 1e9 << std::endl;
+    }
+}
+
+// Serial replay (the ReadTextFile loop) vs the pipelined replay (Pipeline.h: parser, book and formatter threads) of generated logs,
+// with a snapshot after every order so the formatting weighs as much as it can. The two snapshot files must be identical.
+void benchmarkPipeline(const std::vector<uint64_t>& lineCounts) {
+    std::cout << "Serial vs pipelined replay of generated logs, snapshot after every order (ladder book, " << std::thread::hardware_concurrency() << " hardware threads)" << std::endl;
+    std::cout << std::setw(14) << "lines" << std::setw(12) << "serial s" << std::setw(14) << "pipelined s" << std::setw(10) << "speedup" << std::setw(12) << "identical" << std::endl;
+
+    const std::string symbol = FeedGenerator::symbolName(0);
+    const std::string snapshotFiles[2] = { "benchmark_serial.txt", "benchmark_pipelined.txt" };
+    for (uint64_t lineCount : lineCounts) {
+        std::string filePath = "benchmark_" + std::to_string(lineCount) + ".log";
+        if (writeFeedLog(filePath, FeedConfig(), lineCount) == 0) {
+            continue;
+        }
+
+        double seconds[2];
+        for (int run = 0; run < 2; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            {
+                LadderOrderBook orderbook;
+                SnapshotWriter snapshots(snapshotFiles[run], symbol);
+                SymbolTable symbols;
+                uint16_t symbolId = symbols.intern(symbol);
+                TextLogReader file;
+                file.open(filePath);
+                if (run == 0) {
+                    orderbook.setSnapshotWriter(&snapshots);
+                    std::string_view line;
+                    while (file.nextLine(line)) {
+                        Order order;
+                        if (parseOrderLine(line, order, symbols) && order.symbol == symbolId) {
+                            orderbook.processOrder(order, symbol, 1, INT64_MAX);
+                        }
+                    }
+                }
+                else {
+                    bool anyOrderProcessed = false;
+                    int64_t lastTimestamp = 0;
+                    replayPipelined(file, symbols, symbolId, orderbook, snapshots, symbol, 1, INT64_MAX, 5, anyOrderProcessed, lastTimestamp);
+                }
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            seconds[run] = elapsed.count();
+        }
+
+        std::ifstream serial(snapshotFiles[0], std::ios::binary);
+        std::ifstream pipelined(snapshotFiles[1], std::ios::binary);
+        bool identical = std::equal(std::istreambuf_iterator<char>(serial), std::istreambuf_iterator<char>(),
+                                    std::istreambuf_iterator<char>(pipelined), std::istreambuf_iterator<char>());
+        serial.close();
+        pipelined.close();
+        std::remove(filePath.c_str());
+        std::remove(snapshotFiles[0].c_str());
+        std::remove(snapshotFiles[1].c_str());
+
+        std::cout << std::setw(14) << lineCount << std::fixed << std::setprecision(2) << std::setw(12) << seconds[0] << std::setw(14) << seconds[1]
+            << std::setw(9) << seconds[0] / seconds[1] << "x" << std::setw(12) << (identical ? "yes" : "NO") << std::endl;
+    }
+}
+
+// Batch replay (see BatchReplay.h) of generated logs of skewed sizes: one large log, several small ones and a multi symbol log
+// split by symbol, on one worker and on every hardware thread. With enough workers the wall time gets close to the largest job.
+void benchmarkBatch() {
+    std::vector<std::pair<std::string, uint64_t>> logs = { { "benchmark_batch_large.log", 2000000 } };
+    for (int i = 0; i < 8; ++i) {
+        logs.push_back({ "benchmark_batch_small" + std::to_string(i) + ".log", 200000 });
+    }
+    std::vector<ReplayJob> jobs;
+    for (const auto& log : logs) {
+        if (writeFeedLog(log.first, FeedConfig(), log.second) == 0) {
+            return;
+        }
+        ReplayJob job;
+        job.logPath = log.first;
+        job.symbol = FeedGenerator::symbolName(0);
+        job.endTime = INT64_MAX;
+        job.output = log.first + ".snapshots.txt";
+        job.cost = log.second;
+        jobs.push_back(job);
+    }
+    FeedConfig manySymbols;
+    manySymbols.symbolCount = 8;
+    const std::string multiSymbolLog = "benchmark_batch_symbols.log";
+    if (writeFeedLog(multiSymbolLog, manySymbols, 1600000) == 0) {
+        return;
+    }
+    ReplayJob splitJob;
+    splitJob.logPath = multiSymbolLog;
+    splitJob.symbol = "*";
+    splitJob.endTime = INT64_MAX;
+    splitJob.output = multiSymbolLog + ".";
+    splitJob.cost = 1600000;
+    jobs.push_back(splitJob);
+
+    size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "Batch replay of " << logs.size() << " logs (one of 2M lines, 8 of 200k) and a log of 8 symbols split by symbol (ladder books, "
+        << hardwareThreads << " hardware threads)" << std::endl;
+    std::cout << std::setw(10) << "workers" << std::setw(10) << "jobs" << std::setw(12) << "wall s" << std::setw(16) << "largest job s"
+        << std::setw(14) << "sum of jobs s" << std::setw(10) << "stolen" << std::endl;
+    std::vector<ReplayJobResult> results;
+    for (size_t workerCount : { static_cast<size_t>(1), hardwareThreads }) {
+        auto start = std::chrono::steady_clock::now();
+        size_t stealCount = 0;
+        results = runReplayBatch<LadderOrderBook>(jobs, workerCount, &stealCount);
+        std::chrono::duration<double> wallTime = std::chrono::steady_clock::now() - start;
+        double largestJob = 0;
+        double totalJobs = 0;
+        for (const ReplayJobResult& result : results) {
+            largestJob = std::max(largestJob, result.seconds);
+            totalJobs += result.seconds;
+        }
+        std::cout << std::setw(10) << workerCount << std::setw(10) << results.size() << std::fixed << std::setprecision(2) << std::setw(12) << wallTime.count()
+            << std::setw(16) << largestJob << std::setw(14) << totalJobs << std::setw(10) << stealCount << std::endl;
+    }
+
+    for (const ReplayJobResult& result : results) {
+        std::remove(result.job.output.c_str());
+    }
+    for (const auto& log : logs) {
+        std::remove(log.first.c_str());
+    }
+    std::remove(multiSymbolLog.c_str());
+}
+
+// Snapshots after every order vs sampled on time grids (see SnapshotGrid.h) on a generated feed (an event every 0.5 ms on average):
+// time per order, number of snapshots and size of the text snapshot file for each grid interval
+void benchmarkSampling() {
+    const size_t orderCount = 1000000;
+    std::vector<Order> orders = FeedGenerator(FeedConfig()).generate(orderCount);
+    const std::string symbol = FeedGenerator::symbolName(0);
+    const std::string snapshotFile = "benchmark_sampling.txt";
+    const int64_t startTime = orders.front().timestamp;
+    const std::pair<const char*, int64_t> intervals[] = { { "every order", 0 }, { "100 us", 100000 }, { "1 ms", 1000000 }, { "10 ms", 10000000 },
+                                                          { "100 ms", 100000000 }, { "1 s", 1000000000 } };
+
+    std::cout << "Ladder book time per order, snapshots after every order or on a time grid (" << orderCount << " generated orders)" << std::endl;
+    std::cout << std::setw(14) << "interval" << std::setw(12) << "ns/order" << std::setw(14) << "snapshots" << std::setw(12) << "MB" << std::endl;
+    for (const auto& interval : intervals) {
+        std::chrono::duration<double, std::nano> elapsed;
+        uint64_t snapshotCount = 0;
+        {
+            SnapshotWriter snapshots(snapshotFile, symbol);
+            SnapshotGrid grid(startTime, INT64_MAX, interval.second);
+            LadderOrderBook orderbook;
+            orderbook.setSnapshotWriter(&snapshots);
+            if (grid.enabled()) {
+                orderbook.setSnapshotGrid(&grid);
+            }
+            auto start = std::chrono::steady_clock::now();
+            for (const Order& order : orders) {
+                orderbook.processOrder(order, symbol, startTime, INT64_MAX);
+            }
+            orderbook.takeSampledSnapshots(orders.back().timestamp, symbol);
+            snapshots.flush();
+            elapsed = std::chrono::steady_clock::now() - start;
+            snapshotCount = snapshots.recordCount();
+        }
+        std::ifstream written(snapshotFile, std::ios::binary | std::ios::ate);
+        double megabytes = static_cast<double>(std::max<std::streamoff>(written.tellg(), 0)) / 1e6;
+        written.close();
+        std::remove(snapshotFile.c_str());
+
+        std::cout << std::setw(14) << interval.first << std::fixed << std::setprecision(1) << std::setw(12) << elapsed.count() / static_cast<double>(orders.size())
+            << std::setw(14) << snapshotCount << std::setw(12) << megabytes << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string benchmark = argc > 1 ? argv[1] : "all";
+
+    // Benchmark generate <log> <lines> [symbols] [volatility ppm] [orders per side] [cancel %] [trade %]: write a synthetic log
+    if (benchmark == "generate" && argc >= 4) {
+        FeedConfig config;
+        if (argc > 4) config.symbolCount = std::stoi(argv[4]);
+        if (argc > 5) config.volatility = static_cast<uint32_t>(std::stoul(argv[5]));
+        if (argc > 6) config.restingOrdersPerSide = std::stoi(argv[6]);
+        if (argc > 7) config.cancelPercent = std::stoi(argv[7]);
+        if (argc > 8) config.tradePercent = std::stoi(argv[8]);
+        uint64_t bytes = writeFeedLog(argv[2], config, std::stoull(argv[3]));
+        std::cout << bytes << " bytes written to " << argv[2] << std::endl;
+        return 0;
+    }
+
+    // Benchmark replay [lines...]: end to end replay of generated logs of that many lines (1M by default, 10M and 100M take a while)
+    if (benchmark == "replay") {
+        std::vector<uint64_t> lineCounts;
+        for (int i = 2; i < argc; ++i) {
+            lineCounts.push_back(std::stoull(argv[i]));
+        }
+        benchmarkReplay(lineCounts.empty() ? std::vector<uint64_t>{ 1000000 } : lineCounts);
+        return 0;
+    }
+
+    // Benchmark pipeline [lines...]: serial vs pipelined replay of generated logs (1M lines by default)
+    if (benchmark == "pipeline") {
+        std::vector<uint64_t> lineCounts;
+        for (int i = 2; i < argc; ++i) {
+            lineCounts.push_back(std::stoull(argv[i]));
+        }
+        benchmarkPipeline(lineCounts.empty() ? std::vector<uint64_t>{ 1000000 } : lineCounts);
+        return 0;
+    }
+
+    if (benchmark == "all" || benchmark == "cancel") {
+        benchmarkCancelByQueueDepth();
+    }
+    if (benchmark == "all" || benchmark == "latency") {
+        benchmarkLatency();
+    }
+    if (benchmark == "all" || benchmark == "cycles") {
+        benchmarkCycles();
+    }
+    if (benchmark == "all" || benchmark == "readers") {
+        benchmarkConcurrentReaders();
+    }
+    if (benchmark == "all" || benchmark == "matching") {
+        benchmarkMatching();
+    }
+    if (benchmark == "all" || benchmark == "image") {
+        benchmarkBookImage();
+    }
+    if (benchmark == "all" || benchmark == "batch") {
+        benchmarkBatch();
+    }
+    if (benchmark == "all" || benchmark == "sampling") {
+        benchmarkSampling();
+    }
+
+    // Logs to replay can be given after the benchmark name, SCH.log and SCS.log by default
+    std::vector<std::string> filePaths(argv + std::min(argc, 2), argv + argc);
+    if (filePaths.empty()) {
+        filePaths = { "SCH.log", "SCS.log" };
+    }
+    if (benchmark == "all" || benchmark == "book") {
+        benchmarkBookTypes(filePaths);
+    }
+    if (benchmark == "all" || benchmark == "snapshots") {
+        benchmarkSnapshots(filePaths);
+    }
+    if (benchmark == "all" || benchmark == "parse") {
+        benchmarkParse(filePaths);
+    }
+    if (benchmark == "all" || benchmark == "binary") {
+        benchmarkBinaryReplay(filePaths);
+    }
+    if (benchmark == "all" || benchmark == "symbols") {
+        benchmarkSymbolWorkers(filePaths);
+    }
+    if (benchmark == "all" || benchmark == "memory") {
+        benchmarkMemory(filePaths);
+    }
+    if (benchmark == "all") {
+        benchmarkReplay({ 1000000 });
+        benchmarkPipeline({ 1000000 });
+    }
+
+    return 0;
+}
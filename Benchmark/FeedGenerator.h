@@ -0,0 +1,227 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <charconv>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+
+#include "Order.h"
+#include "SymbolTable.h"
+
+// Parameters of a synthetic feed
+struct FeedConfig {
+    uint64_t seed = 1;
+    int symbolCount = 1;
+    // Probability (in millionths) that the mid price of a symbol moves by one tick on each of its events
+    uint32_t volatility = 20000;
+    // Number of orders resting on each side of a symbol the feed keeps around (the depth of the queues),
+    // and number of ticks away from the mid a NEW order can be placed at (the orders spread over that many levels)
+    int restingOrdersPerSide = 500;
+    int levelsPerSide = 20;
+    // Mix of the events in percents, the rest of 100 is NEW
+    int cancelPercent = 35;
+    int tradePercent = 15;
+    int maxQuantity = 20;
+};
+
+// Deterministic generator of valid order events (every CANCEL and TRADE refers to an order the book has):
+// the same config gives the same events on every platform (std::mt19937_64 output is specified by the standard,
+// the distributions are not, so only its raw output is used).
+// The generator mirrors the book of each symbol (FIFO of every level) to know which orders are resting.
+class FeedGenerator
+{
+private:
+    static constexpr int64_t FIRST_TIMESTAMP = 1609723800000000000;
+    static constexpr int64_t INITIAL_MID = 10670; // 106.70
+
+    struct Resting {
+        int64_t price;
+        int32_t quantity;
+        size_t position; // in the orderIds vector of its side
+    };
+
+    struct BookSide {
+        std::vector<int64_t> orderIds; // resting orders, to pick one at random
+        std::unordered_map<int64_t, Resting> orders;
+        std::unordered_map<int64_t, std::deque<int64_t>> levels; // FIFO of the orderIds at each price
+    };
+
+    struct SymbolState {
+        int64_t mid = INITIAL_MID;
+        BookSide sides[2]; // BUY, SELL
+    };
+
+    FeedConfig config;
+    std::mt19937_64 rng;
+    std::vector<SymbolState> symbols;
+    int64_t timestamp = FIRST_TIMESTAMP;
+    int64_t nextOrderId = 1;
+
+    uint64_t uniform(uint64_t bound) {
+        return rng() % bound;
+    }
+
+    void removeOrder(BookSide& side, int64_t orderId) {
+        auto resting = side.orders.find(orderId);
+        size_t position = resting->second.position;
+        side.orderIds[position] = side.orderIds.back();
+        side.orders[side.orderIds[position]].position = position;
+        side.orderIds.pop_back();
+
+        auto level = side.levels.find(resting->second.price);
+        level->second.erase(std::find(level->second.begin(), level->second.end(), orderId));
+        if (level->second.empty()) {
+            side.levels.erase(level);
+        }
+        side.orders.erase(resting);
+    }
+
+public:
+    explicit FeedGenerator(const FeedConfig& config)
+        : config(config), rng(config.seed), symbols(static_cast<size_t>(std::max(config.symbolCount, 1))) {
+    }
+
+    // Name of the symbol with that id, the ids are given in order so they match a SymbolTable filled with symbolName(0), symbolName(1), ...
+    static std::string symbolName(int symbol) {
+        return "S" + std::to_string(symbol);
+    }
+
+    Order next() {
+        timestamp += 1 + static_cast<int64_t>(uniform(1000000));
+        uint16_t symbol = static_cast<uint16_t>(uniform(symbols.size()));
+        SymbolState& state = symbols[symbol];
+        if (uniform(1000000) < config.volatility) {
+            state.mid += uniform(2) ? 1 : -1;
+            state.mid = std::max<int64_t>(state.mid, config.levelsPerSide + 1);
+        }
+
+        int sideIndex = static_cast<int>(uniform(2));
+        BookSide& side = state.sides[sideIndex];
+        int roll = static_cast<int>(uniform(100));
+        Category category = roll < config.cancelPercent ? Category::Cancel : roll < config.cancelPercent + config.tradePercent ? Category::Trade : Category::New;
+        // Keep the depth around the target: no CANCEL or TRADE on an empty side, no NEW on a side twice as deep as wanted
+        if (side.orderIds.empty()) {
+            category = Category::New;
+        }
+        else if (category == Category::New && side.orderIds.size() >= 2 * static_cast<size_t>(config.restingOrdersPerSide)) {
+            category = Category::Cancel;
+        }
+        else if (category != Category::New && side.orderIds.size() < static_cast<size_t>(config.restingOrdersPerSide) / 2) {
+            category = Category::New;
+        }
+
+        Order order = { timestamp, 0, 0, 0, symbol, sideIndex == 0 ? Side::Buy : Side::Sell, category };
+        if (category == Category::New) {
+            int64_t distance = 1 + static_cast<int64_t>(uniform(static_cast<uint64_t>(std::max(config.levelsPerSide, 1))));
+            order.orderId = nextOrderId++;
+            order.price = sideIndex == 0 ? state.mid - distance : state.mid + distance;
+            order.quantity = 1 + static_cast<int32_t>(uniform(static_cast<uint64_t>(std::max(config.maxQuantity, 1))));
+            side.orders[order.orderId] = { order.price, order.quantity, side.orderIds.size() };
+            side.orderIds.push_back(order.orderId);
+            side.levels[order.price].push_back(order.orderId);
+        }
+        else if (category == Category::Cancel) {
+            order.orderId = side.orderIds[uniform(side.orderIds.size())];
+            const Resting& resting = side.orders[order.orderId];
+            order.price = resting.price;
+            order.quantity = resting.quantity;
+            removeOrder(side, order.orderId);
+        }
+        else {
+            // Trade part or all of the order at the front of the level of a random resting order
+            int64_t price = side.orders[side.orderIds[uniform(side.orderIds.size())]].price;
+            int64_t frontId = side.levels[price].front();
+            Resting& front = side.orders[frontId];
+            order.orderId = frontId;
+            order.price = price;
+            order.quantity = 1 + static_cast<int32_t>(uniform(static_cast<uint64_t>(front.quantity)));
+            front.quantity -= order.quantity;
+            if (front.quantity == 0) {
+                removeOrder(side, frontId);
+            }
+        }
+        return order;
+    }
+
+    std::vector<Order> generate(size_t count) {
+        std::vector<Order> orders;
+        orders.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            orders.push_back(next());
+        }
+        return orders;
+    }
+
+    // Fill the symbol table with the names of the symbols of the feed (ids 0, 1, ...)
+    void nameSymbols(SymbolTable& table) const {
+        for (size_t symbol = 0; symbol < symbols.size(); ++symbol) {
+            table.intern(symbolName(static_cast<int>(symbol)));
+        }
+    }
+};
+
+// Write `count` events of the feed as a text log (timestamp orderId symbol side category price quantity)
+// Returns the number of bytes written
+inline uint64_t writeFeedLog(const std::string& filePath, const FeedConfig& config, uint64_t count) {
+    std::ofstream file(filePath, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Unable to open file for writing!" << std::endl;
+        return 0;
+    }
+    FeedGenerator generator(config);
+    std::vector<std::string> names;
+    for (int symbol = 0; symbol < std::max(config.symbolCount, 1); ++symbol) {
+        names.push_back(FeedGenerator::symbolName(symbol));
+    }
+
+    std::vector<char> buffer(1 << 20);
+    size_t used = 0;
+    uint64_t bytesWritten = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        if (buffer.size() - used < 256) {
+            file.write(buffer.data(), static_cast<std::streamsize>(used));
+            bytesWritten += used;
+            used = 0;
+        }
+        Order order = generator.next();
+        char* out = buffer.data() + used;
+        char* end = buffer.data() + buffer.size();
+        out = std::to_chars(out, end, order.timestamp).ptr;
+        *out++ = ' ';
+        out = std::to_chars(out, end, order.orderId).ptr;
+        *out++ = ' ';
+        const std::string& name = names[order.symbol];
+        std::memcpy(out, name.data(), name.size());
+        out += name.size();
+        *out++ = ' ';
+        const char* side = sideToString(order.side);
+        std::memcpy(out, side, std::strlen(side));
+        out += std::strlen(side);
+        *out++ = ' ';
+        const char* category = categoryToString(order.category);
+        std::memcpy(out, category, std::strlen(category));
+        out += std::strlen(category);
+        *out++ = ' ';
+        // Price with exactly PRICE_DECIMALS decimals, like the recorded logs
+        out = std::to_chars(out, end, order.price / TICKS_PER_UNIT).ptr;
+        *out++ = '.';
+        int64_t fraction = order.price % TICKS_PER_UNIT;
+        for (int64_t digit = TICKS_PER_UNIT / 10; digit > 0; digit /= 10) {
+            *out++ = static_cast<char>('0' + (fraction / digit) % 10);
+        }
+        *out++ = ' ';
+        out = std::to_chars(out, end, order.quantity).ptr;
+        *out++ = '\n';
+        used = static_cast<size_t>(out - buffer.data());
+    }
+    file.write(buffer.data(), static_cast<std::streamsize>(used));
+    bytesWritten += used;
+    return bytesWritten;
+}
@@ -0,0 +1,348 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+
+#include "Order.h"
+#include "SymbolTable.h"
+#include "TextLog.h"
+#include "EventLog.h"
+#include "SnapshotWriter.h"
+#include "Checkpoint.h"
+#include "WorkStealingPool.h"
+
+// Batch replay: many (log, symbol, time window) queries in one process, each replayed in its own order book on a
+// WorkStealingPool, instead of one process per query. The jobs are started from the largest log to the smallest one and an
+// idle worker takes the jobs queued on busy workers, so the batch takes about as long as its largest job when there are
+// enough workers. A job on every symbol of a log ("*") is split into one job per symbol of the log, run like the others: the
+// split reads the log once and gives each job the positions of its lines, so a job reads its own lines instead of the whole log.
+//
+// Manifest: one job per line, empty lines and lines starting with # are skipped
+//   <log> <symbol|*> <startTime> <endTime> [output]
+// Like the single symbol query, a start time of 0 only writes the snapshot at the end of the window. The snapshots of a
+// job go to its output (text snapshots), for a "*" job the output is a prefix followed by <symbol>.txt. Without an output,
+// a job writes to <log name>_<startTime>_<endTime>_<symbol>.txt in the current directory.
+
+struct ReplayJob {
+    std::string logPath;
+    std::string symbol; // "*" for every symbol of the log
+    int64_t startTime = 0;
+    int64_t endTime = 0;
+    std::string output; // snapshot file, or its prefix for a "*" job
+    uint64_t cost = 0; // estimated size of the job (bytes or lines of the log), the largest jobs are started first
+    size_t line = 0; // line of the manifest, the results are given in the manifest order
+    // Positions of the lines of the symbol up to the end time (byte offsets in a text log, record indexes in a binary log),
+    // given by the split of a "*" job. Without them the job scans the log for the lines of its symbol.
+    std::shared_ptr<const std::vector<uint64_t>> positions;
+};
+
+struct ReplayJobResult {
+    ReplayJob job;
+    bool succeeded = false;
+    uint64_t ordersProcessed = 0;
+    uint64_t rejects = 0;
+    uint64_t snapshotsWritten = 0;
+    double seconds = 0;
+};
+
+// Name of the log without its directory and extension
+inline std::string logBaseName(const std::string& logPath) {
+    size_t start = logPath.find_last_of("/\\");
+    start = start == std::string::npos ? 0 : start + 1;
+    size_t end = logPath.find_last_of('.');
+    if (end == std::string::npos || end < start) {
+        end = logPath.size();
+    }
+    return logPath.substr(start, end - start);
+}
+
+inline std::string defaultJobOutputPrefix(const ReplayJob& job) {
+    return logBaseName(job.logPath) + "_" + std::to_string(job.startTime) + "_" + std::to_string(job.endTime) + "_";
+}
+
+// Read the jobs of a manifest, the malformed lines are reported and skipped
+// Returns false if the manifest can't be read
+inline bool readReplayManifest(const std::string& manifestPath, std::vector<ReplayJob>& jobs) {
+    std::ifstream manifest(manifestPath);
+    if (!manifest.is_open()) {
+        std::cerr << "Unable to open manifest " << manifestPath << std::endl;
+        return false;
+    }
+    std::string line;
+    for (size_t lineNumber = 1; std::getline(manifest, line); ++lineNumber) {
+        std::istringstream fields(line);
+        ReplayJob job;
+        if (!(fields >> job.logPath) || job.logPath[0] == '#') {
+            continue;
+        }
+        if (!(fields >> job.symbol >> job.startTime >> job.endTime)) {
+            std::cerr << manifestPath << ":" << lineNumber << ": expected <log> <symbol|*> <startTime> <endTime> [output], line skipped" << std::endl;
+            continue;
+        }
+        fields >> job.output;
+        job.line = lineNumber;
+        if (job.output.empty()) {
+            job.output = defaultJobOutputPrefix(job) + (job.symbol == "*" ? "" : job.symbol + ".txt");
+        }
+        std::ifstream log(job.logPath, std::ios::binary | std::ios::ate);
+        job.cost = log.is_open() ? static_cast<uint64_t>(log.tellg()) : 0;
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+// Replay one job in its own book, quietly (the parse errors are counted with the rejects)
+template <typename Book>
+ReplayJobResult runReplayJob(const ReplayJob& job) {
+    auto start = std::chrono::steady_clock::now();
+    ReplayJobResult result;
+    result.job = job;
+    result.job.positions.reset(); // the results are kept until the end of the batch, the positions aren't needed anymore
+    if (!std::ifstream(job.logPath).is_open()) {
+        std::cerr << "Unable to open " << job.logPath << std::endl;
+        return result;
+    }
+    Book orderbook;
+    SnapshotWriter snapshots(job.output, job.symbol, SnapshotFormat::Text);
+    if (job.startTime != 0) {
+        orderbook.setSnapshotWriter(&snapshots);
+    }
+    int numberOfFields = SNAPSHOT_DEPTH;
+    bool anyOrderProcessed = false;
+    int64_t lastTimestamp = 0;
+    uint64_t parseErrors = 0;
+
+    auto processOrder = [&](const Order& order) {
+        orderbook.processOrder(order, job.symbol, job.startTime, job.endTime, numberOfFields);
+        anyOrderProcessed = true;
+        lastTimestamp = order.timestamp;
+        result.ordersProcessed++;
+    };
+
+    // Same replay as ReadTextFile and ReadBinaryFile, from the last checkpoint before the window if the log has some
+    CheckpointIndexEntry checkpoint;
+    if (isBinaryLog(job.logPath)) {
+        BinaryLogReader log;
+        if (!log.open(job.logPath)) {
+            return result;
+        }
+        const Order* first = log.begin();
+        if (restoreLastCheckpoint(job.logPath, job.symbol, log.size(), job.startTime, job.endTime, orderbook, checkpoint)) {
+            first += checkpoint.position;
+            anyOrderProcessed = checkpoint.ordersProcessed > 0;
+            lastTimestamp = checkpoint.lastOrderTimestamp;
+        }
+        if (job.positions) {
+            const std::vector<uint64_t>& records = *job.positions;
+            uint64_t firstRecord = static_cast<uint64_t>(first - log.begin());
+            for (auto record = std::lower_bound(records.begin(), records.end(), firstRecord); record != records.end() && *record < log.size(); ++record) {
+                processOrder(log.begin()[*record]);
+            }
+        }
+        else {
+            uint16_t symbolId = log.symbolTable().find(job.symbol);
+            for (const Order* order = first; order != log.end() && order->timestamp <= job.endTime; ++order) {
+                if (order->symbol == symbolId) {
+                    processOrder(*order);
+                }
+            }
+        }
+    }
+    else {
+        TextLogReader file;
+        if (!file.open(job.logPath)) {
+            std::cerr << "Unable to open " << job.logPath << std::endl;
+            return result;
+        }
+        if (restoreLastCheckpoint(job.logPath, job.symbol, file.size(), job.startTime, job.endTime, orderbook, checkpoint)) {
+            file.seek(checkpoint.position);
+            anyOrderProcessed = checkpoint.ordersProcessed > 0;
+            lastTimestamp = checkpoint.lastOrderTimestamp;
+        }
+        SymbolTable symbols;
+        std::string_view line;
+        if (job.positions) {
+            // Only the lines of the job, the split gave their positions
+            const std::vector<uint64_t>& offsets = *job.positions;
+            for (auto offset = std::lower_bound(offsets.begin(), offsets.end(), file.offset()); offset != offsets.end(); ++offset) {
+                if (!file.seek(*offset) || !file.nextLine(line)) {
+                    break;
+                }
+                Order order;
+                if (!parseOrderLine(line, order, symbols)) {
+                    parseErrors++;
+                    continue;
+                }
+                if (order.timestamp > job.endTime) {
+                    break;
+                }
+                processOrder(order);
+            }
+        }
+        else {
+            // Only the lines of the symbol are parsed, but the timestamp of the other lines is checked too: a job on a symbol
+            // that stops trading early stops at its end time instead of reading the log to its end
+            std::string endTimeDigits = std::to_string(job.endTime);
+            while (file.nextLine(line)) {
+                std::string_view timestamp;
+                if (lineSymbol(line, timestamp) != job.symbol) {
+                    if (timestampAfter(timestamp, job.endTime, endTimeDigits)) {
+                        break;
+                    }
+                    continue;
+                }
+                Order order;
+                if (!parseOrderLine(line, order, symbols)) {
+                    parseErrors++;
+                    continue;
+                }
+                if (order.timestamp > job.endTime) {
+                    break;
+                }
+                processOrder(order);
+            }
+        }
+    }
+
+    if (job.startTime == 0 && anyOrderProcessed) {
+        orderbook.setSnapshotWriter(&snapshots);
+        orderbook.takeSnapshot(lastTimestamp, job.symbol, numberOfFields);
+    }
+    snapshots.flush();
+    result.succeeded = true;
+    result.rejects = orderbook.getMetrics().totalRejects() + parseErrors;
+    result.snapshotsWritten = snapshots.recordCount();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+// One job per symbol of the log of a "*" job (the symbols with an order up to the end time), largest first,
+// the cost of a job is its number of orders in the window. The log is read once here, each job gets the positions of its lines.
+inline std::vector<ReplayJob> splitJobBySymbol(const ReplayJob& job) {
+    std::vector<uint64_t> orderCounts;
+    std::vector<std::vector<uint64_t>> positions;
+    SymbolTable textSymbols;
+    const SymbolTable* symbols = &textSymbols;
+    BinaryLogReader log;
+    auto addPosition = [&](uint16_t symbol, uint64_t position) {
+        if (symbol >= positions.size()) {
+            orderCounts.resize(symbol + 1);
+            positions.resize(symbol + 1);
+        }
+        positions[symbol].push_back(position);
+    };
+    auto count = [&](const Order& order, uint64_t position) {
+        addPosition(order.symbol, position);
+        orderCounts[order.symbol]++;
+    };
+    if (isBinaryLog(job.logPath)) {
+        if (!log.open(job.logPath)) {
+            return {};
+        }
+        symbols = &log.symbolTable();
+        for (const Order* order = log.begin(); order != log.end() && order->timestamp <= job.endTime; ++order) {
+            count(*order, static_cast<uint64_t>(order - log.begin()));
+        }
+    }
+    else {
+        TextLogReader file;
+        if (!file.open(job.logPath)) {
+            std::cerr << "Unable to open " << job.logPath << std::endl;
+            return {};
+        }
+        std::string_view line;
+        std::string endTimeDigits = std::to_string(job.endTime);
+        uint64_t lineStart = file.offset();
+        while (file.nextLine(line)) {
+            // Same end as the symbol jobs, the first line past the end time
+            Order order;
+            if (parseOrderLine(line, order, textSymbols)) {
+                if (order.timestamp > job.endTime) {
+                    break;
+                }
+                count(order, lineStart);
+            }
+            else {
+                std::string_view timestamp;
+                std::string_view symbol = lineSymbol(line, timestamp);
+                if (timestampAfter(timestamp, job.endTime, endTimeDigits)) {
+                    break;
+                }
+                // A line that can't be parsed still goes to the job of its symbol, which counts it with its rejects
+                uint16_t symbolId = symbol.empty() ? SymbolTable::NO_SYMBOL : textSymbols.intern(symbol);
+                if (symbolId != SymbolTable::NO_SYMBOL) {
+                    addPosition(symbolId, lineStart);
+                }
+            }
+            lineStart = file.offset();
+        }
+    }
+
+    std::vector<ReplayJob> symbolJobs;
+    for (uint16_t id = 0; id < orderCounts.size(); ++id) {
+        if (orderCounts[id] > 0) {
+            ReplayJob symbolJob = job;
+            symbolJob.symbol = symbols->name(id);
+            symbolJob.output = job.output + symbolJob.symbol + ".txt";
+            symbolJob.cost = orderCounts[id];
+            symbolJob.positions = std::make_shared<const std::vector<uint64_t>>(std::move(positions[id]));
+            symbolJobs.push_back(symbolJob);
+        }
+    }
+    std::stable_sort(symbolJobs.begin(), symbolJobs.end(), [](const ReplayJob& a, const ReplayJob& b) {
+        return a.cost > b.cost;
+    });
+    return symbolJobs;
+}
+
+// Run every job of the batch on that many workers, returns the result of every job (the "*" jobs are replaced by the jobs of their symbols)
+template <typename Book>
+std::vector<ReplayJobResult> runReplayBatch(std::vector<ReplayJob> jobs, size_t workerCount, size_t* stealCount = nullptr) {
+    WorkStealingPool pool(workerCount);
+    // Every worker keeps the results of its jobs, nothing is shared while the jobs run
+    std::vector<std::vector<ReplayJobResult>> results(pool.workerCount());
+
+    auto replay = [&results](const ReplayJob& job) {
+        return [&results, job](WorkStealingPool&, size_t worker) {
+            results[worker].push_back(runReplayJob<Book>(job));
+        };
+    };
+    // Largest log first, dealt to the workers in turn: each worker starts with a large job
+    std::stable_sort(jobs.begin(), jobs.end(), [](const ReplayJob& a, const ReplayJob& b) {
+        return a.cost > b.cost;
+    });
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (jobs[i].symbol == "*") {
+            // Reading the log for its symbols is a task too, its symbol jobs go to the queue of the worker that read it
+            pool.submit([replay, job = jobs[i]](WorkStealingPool& pool, size_t worker) {
+                for (const ReplayJob& symbolJob : splitJobBySymbol(job)) {
+                    pool.submit(replay(symbolJob), worker);
+                }
+            }, i);
+        }
+        else {
+            pool.submit(replay(jobs[i]), i);
+        }
+    }
+    pool.run();
+    if (stealCount != nullptr) {
+        *stealCount = pool.stealCount();
+    }
+
+    std::vector<ReplayJobResult> allResults;
+    for (std::vector<ReplayJobResult>& workerResults : results) {
+        allResults.insert(allResults.end(), workerResults.begin(), workerResults.end());
+    }
+    std::sort(allResults.begin(), allResults.end(), [](const ReplayJobResult& a, const ReplayJobResult& b) {
+        return a.job.line != b.job.line ? a.job.line < b.job.line : a.job.symbol < b.job.symbol;
+    });
+    return allResults;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "Order.h"
+
+// Analytics of the top of the book, kept up to date by the book instead of being recomputed by every consumer from the
+// snapshot text. Each side keeps the running sums of its top N levels (see DepthCache): a quantity change inside the top N
+// adjusts them in O(1), a change of the top N levels sums the contiguous array of levels again.
+
+// Sums over the top N levels of one side
+struct DepthSums {
+    int64_t quantity = 0;
+    int64_t notional = 0; // sum of price (in ticks) x quantity
+};
+
+// Sum the levels of a top N view (a contiguous array, the loop has no dependency between iterations but the two sums)
+inline DepthSums sumLevels(const DepthLevel* levels, size_t count) {
+    DepthSums sums;
+    for (size_t i = 0; i < count; ++i) {
+        sums.quantity += levels[i].quantity;
+        sums.notional += levels[i].price * levels[i].quantity;
+    }
+    return sums;
+}
+
+// Prices are in ticks (like everywhere in the book), divide by TICKS_PER_UNIT for the price
+struct BookAnalytics {
+    bool hasBid = false;
+    bool hasAsk = false;
+    double mid = 0; // (best bid + best ask) / 2, needs both sides
+    double microprice = 0; // best bid and best ask weighted by the quantity on the other side, needs both sides
+    double imbalance = 0; // (bid quantity - ask quantity) / (bid quantity + ask quantity) over the top N levels, in [-1, 1]
+    double bidVwap = 0; // average price of the quantity of the top N bid levels, needs a bid
+    double askVwap = 0; // same for the asks, needs an ask
+};
+
+// O(1) from the best level and the sums of each side (bestBid/bestAsk are nullptr if that side is empty)
+inline BookAnalytics computeBookAnalytics(const DepthLevel* bestBid, const DepthSums& bidSums, const DepthLevel* bestAsk, const DepthSums& askSums) {
+    BookAnalytics analytics;
+    analytics.hasBid = bestBid != nullptr && bidSums.quantity > 0;
+    analytics.hasAsk = bestAsk != nullptr && askSums.quantity > 0;
+    if (analytics.hasBid) {
+        analytics.bidVwap = static_cast<double>(bidSums.notional) / static_cast<double>(bidSums.quantity);
+    }
+    if (analytics.hasAsk) {
+        analytics.askVwap = static_cast<double>(askSums.notional) / static_cast<double>(askSums.quantity);
+    }
+    if (analytics.hasBid && analytics.hasAsk) {
+        double bidPrice = static_cast<double>(bestBid->price);
+        double askPrice = static_cast<double>(bestAsk->price);
+        double bidQuantity = static_cast<double>(bestBid->quantity);
+        double askQuantity = static_cast<double>(bestAsk->quantity);
+        analytics.mid = (bidPrice + askPrice) / 2;
+        analytics.microprice = bidQuantity + askQuantity > 0 ? (bidPrice * askQuantity + askPrice * bidQuantity) / (bidQuantity + askQuantity) : analytics.mid;
+        analytics.imbalance = static_cast<double>(bidSums.quantity - askSums.quantity) / static_cast<double>(bidSums.quantity + askSums.quantity);
+    }
+    return analytics;
+}
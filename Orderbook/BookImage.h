@@ -0,0 +1,234 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "Order.h"
+#include "SymbolTable.h"
+#include "MappedFile.h"
+#include "TextLog.h"
+#include "EventLog.h"
+
+// Image of the whole book of one symbol (every level and every resting order in FIFO order) saved at any timestamp of a
+// log, so a query or a restart can start from it instead of replaying the log up to that time:
+//   BookImageHeader
+//   bidLevelCount + askLevelCount x BookImageLevel (bids then asks, best price first)
+//   orderCount x BookImageOrder (the orders of each level in FIFO order, level after level)
+// The file is memory mapped and the book rebuilt level by level (see BasicOrderBook::restoreLevel): one insert per level and
+// its orders linked in place, nothing goes through processOrder. Written by "Orderbook save", the time range queries start
+// from it like from a checkpoint when it is the closest one before their window (see restoreLastCheckpoint).
+
+constexpr char BOOK_IMAGE_MAGIC[8] = { 'O', 'B', 'I', 'M', 'A', 'G', 'E', '1' };
+constexpr uint32_t BOOK_IMAGE_VERSION = 1;
+
+struct BookImageHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    int64_t ticksPerUnit;
+    uint64_t logLength; // size of the log (bytes or records) when the image was saved, 0 if it wasn't saved from a log
+    char symbol[32]; // null terminated
+    int64_t timestamp; // every line of the log up to that timestamp (included) is in the image
+    uint64_t position; // position of the next line in the log: byte offset for a text log, record index for a binary log
+    int64_t lastOrderTimestamp; // timestamp of the last order of the symbol processed (meaningless if ordersProcessed is 0)
+    uint64_t ordersProcessed; // orders of the symbol processed before the image
+    uint64_t bidLevelCount;
+    uint64_t askLevelCount;
+    uint64_t orderCount;
+};
+
+struct BookImageLevel {
+    int64_t price; // in ticks
+    uint32_t orderCount;
+    int32_t quantity; // sum of the quantities of its orders
+};
+
+struct BookImageOrder {
+    int64_t orderId;
+    int32_t quantity;
+    uint32_t indexed; // see BasicOrderBook::forEachRestingOrder
+};
+
+static_assert(sizeof(BookImageHeader) % alignof(BookImageLevel) == 0, "levels must stay aligned after the header");
+static_assert(sizeof(BookImageLevel) % alignof(BookImageOrder) == 0, "orders must stay aligned after the levels");
+
+// Image of a symbol goes next to the log
+inline std::string bookImageFileName(const std::string& logPath, const std::string& symbol) {
+    return logPath + "." + symbol + ".image";
+}
+
+// Write the image of the book, the header gives the symbol and where the book is in its log (the counts are filled here)
+// Returns false if the file can't be written
+template <typename Book>
+bool writeBookImage(Book& book, BookImageHeader header, const std::string& imagePath) {
+    std::vector<BookImageLevel> levels;
+    std::vector<BookImageOrder> orders;
+    Side levelSide = Side::Unknown;
+    book.forEachRestingOrder([&](const Order& order, bool indexed) {
+        // The orders come level after level, a new price (or side) starts a new level
+        if (levels.empty() || order.side != levelSide || order.price != levels.back().price) {
+            levels.push_back({ order.price, 0, 0 });
+            levelSide = order.side;
+            if (order.side == Side::Buy) {
+                header.bidLevelCount++;
+            }
+        }
+        levels.back().orderCount++;
+        levels.back().quantity += order.quantity;
+        orders.push_back({ order.orderId, order.quantity, indexed ? 1u : 0u });
+    });
+
+    std::memcpy(header.magic, BOOK_IMAGE_MAGIC, sizeof(header.magic));
+    header.version = BOOK_IMAGE_VERSION;
+    header.ticksPerUnit = TICKS_PER_UNIT;
+    header.askLevelCount = levels.size() - header.bidLevelCount;
+    header.orderCount = orders.size();
+
+    std::ofstream imageFile(imagePath, std::ios::binary);
+    if (!imageFile.is_open()) {
+        std::cerr << "Unable to open book image file for writing!" << std::endl;
+        return false;
+    }
+    imageFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    imageFile.write(reinterpret_cast<const char*>(levels.data()), static_cast<std::streamsize>(levels.size() * sizeof(BookImageLevel)));
+    imageFile.write(reinterpret_cast<const char*>(orders.data()), static_cast<std::streamsize>(orders.size() * sizeof(BookImageOrder)));
+    if (!imageFile) {
+        std::cerr << "Error writing book image file!" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Replay the log for one symbol up to that timestamp (included) and save the image of its book
+// Returns false if the log can't be read or the image can't be written
+template <typename Book>
+bool saveBookImage(const std::string& logPath, const std::string& symbol, int64_t timestamp, const std::string& imagePath) {
+    Book book;
+    BookImageHeader header = {};
+    std::memcpy(header.symbol, symbol.data(), std::min(symbol.size(), sizeof(header.symbol) - 1));
+    header.timestamp = timestamp;
+
+    auto processOrder = [&](const Order& order, uint16_t symbolId) {
+        if (order.symbol == symbolId) {
+            book.processOrder(order, symbol);
+            header.lastOrderTimestamp = order.timestamp;
+            header.ordersProcessed++;
+        }
+    };
+
+    if (isBinaryLog(logPath)) {
+        BinaryLogReader log;
+        if (!log.open(logPath)) {
+            return false;
+        }
+        header.logLength = log.size();
+        uint16_t symbolId = log.symbolTable().find(symbol);
+        uint64_t record = 0;
+        // The log is sorted by timestamp, the image stops before the first order after the timestamp
+        for (; record < log.size() && log.begin()[record].timestamp <= timestamp; ++record) {
+            processOrder(log.begin()[record], symbolId);
+        }
+        header.position = record;
+    }
+    else {
+        TextLogReader file;
+        if (!file.open(logPath)) {
+            std::cerr << "Unable to open file!" << std::endl;
+            return false;
+        }
+        header.logLength = file.size();
+        SymbolTable symbols;
+        uint16_t symbolId = symbols.intern(symbol);
+        std::string_view line;
+        size_t lineStart = file.offset();
+        while (file.nextLine(line)) {
+            Order order;
+            if (parseOrderLine(line, order, symbols)) {
+                if (order.timestamp > timestamp) {
+                    break;
+                }
+                processOrder(order, symbolId);
+            }
+            lineStart = file.offset();
+        }
+        header.position = lineStart;
+    }
+    return writeBookImage(book, header, imagePath);
+}
+
+// Memory mapped book image
+class BookImageReader
+{
+private:
+    MappedFile file;
+    BookImageHeader header = {};
+    const BookImageLevel* levels = nullptr;
+    const BookImageOrder* orders = nullptr;
+
+public:
+    // Returns false if there is no usable image (missing, other version, truncated, or saved from a log of another length
+    // if logLength isn't 0)
+    bool open(const std::string& imagePath, uint64_t logLength = 0) {
+        if (!file.open(imagePath) || file.size() < sizeof(header)) {
+            return false;
+        }
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, BOOK_IMAGE_MAGIC, sizeof(header.magic)) != 0 || header.version != BOOK_IMAGE_VERSION || header.ticksPerUnit != TICKS_PER_UNIT) {
+            std::cerr << "Book image was written with another version of the format, ignored" << std::endl;
+            return false;
+        }
+        if (logLength != 0 && header.logLength != logLength) {
+            std::cerr << "Log changed since the book image was saved, ignored" << std::endl;
+            return false;
+        }
+        uint64_t levelCount = header.bidLevelCount + header.askLevelCount;
+        uint64_t available = file.size() - sizeof(header);
+        if (levelCount < header.bidLevelCount || available / sizeof(BookImageLevel) < levelCount
+            || (available - levelCount * sizeof(BookImageLevel)) / sizeof(BookImageOrder) < header.orderCount) {
+            std::cerr << "Book image is truncated, ignored" << std::endl;
+            return false;
+        }
+        levels = reinterpret_cast<const BookImageLevel*>(file.data() + sizeof(header));
+        orders = reinterpret_cast<const BookImageOrder*>(file.data() + sizeof(header) + levelCount * sizeof(BookImageLevel));
+        // restoreLevel creates a new level for each price, so a price given twice on a side (or out of order, which is how a
+        // repeated price would hide) is refused here rather than linking two FIFOs into one level of the book
+        uint64_t ordersInLevels = 0;
+        bool sorted = true;
+        for (uint64_t i = 0; i < levelCount; ++i) {
+            ordersInLevels += levels[i].orderCount;
+            if (i != 0 && i != header.bidLevelCount) {
+                sorted = sorted && (i < header.bidLevelCount ? CompareBids()(levels[i - 1].price, levels[i].price) : CompareAsks()(levels[i - 1].price, levels[i].price));
+            }
+        }
+        if (ordersInLevels != header.orderCount || !sorted) {
+            std::cerr << "Book image is corrupted, ignored" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    const BookImageHeader& getHeader() const {
+        return header;
+    }
+
+    // Rebuild the saved book in an empty book, level by level
+    template <typename Book>
+    void restore(Book& book) const {
+        uint64_t levelCount = header.bidLevelCount + header.askLevelCount;
+        uint64_t bidOrders = 0;
+        for (uint64_t i = 0; i < header.bidLevelCount; ++i) {
+            bidOrders += levels[i].orderCount;
+        }
+        book.reserveRestingOrders(bidOrders, header.orderCount - bidOrders);
+        const BookImageOrder* levelOrders = orders;
+        for (uint64_t i = 0; i < levelCount; ++i) {
+            book.restoreLevel(i < header.bidLevelCount ? Side::Buy : Side::Sell, levels[i].price, levelOrders, levels[i].orderCount);
+            levelOrders += levels[i].orderCount;
+        }
+    }
+};
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+#include "Order.h"
+#include "SymbolTable.h"
+#include "SnapshotWriter.h"
+
+// Bounded FIFO of batches of orders between the thread reading the log and one worker thread
+class OrderBatchQueue
+{
+private:
+    static constexpr size_t MAX_QUEUED_BATCHES = 64; // the reader waits when a worker is this far behind
+
+    std::deque<std::vector<Order>> batches;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    bool closed = false;
+
+public:
+    void push(std::vector<Order>&& batch) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this] { return batches.size() < MAX_QUEUED_BATCHES; });
+        batches.push_back(std::move(batch));
+        notEmpty.notify_one();
+    }
+
+    // Wait for the next batch, returns false once the queue is closed and empty
+    bool pop(std::vector<Order>& batch) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this] { return !batches.empty() || closed; });
+        if (batches.empty()) {
+            return false;
+        }
+        batch = std::move(batches.front());
+        batches.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notEmpty.notify_all();
+    }
+};
+
+// Routes the orders of a multi symbol log to one order book per symbol.
+// The symbols are partitioned across a pool of worker threads (symbol id modulo the number of workers): every order of a
+// symbol goes through the same FIFO to the same worker, so the orders of each symbol are processed in the log order.
+template <typename Book>
+class BookManager
+{
+public:
+    struct SymbolBook {
+        std::string symbol;
+        Book book;
+        std::unique_ptr<SnapshotWriter> snapshots; // snapshot file of the symbol, nullptr if the snapshots aren't saved
+        uint64_t ordersProcessed = 0;
+        int64_t lastTimestamp = 0; // timestamp of the last order processed
+    };
+
+private:
+    static constexpr size_t BATCH_SIZE = 4096; // orders handed to a worker at once
+    // Largest write buffer of a snapshot file, smaller than the default since there is one file per symbol. The buffer of a
+    // symbol only grows to it with the snapshots of that symbol, and the file is only open while the buffer is written to it,
+    // so a log with thousands of symbols doesn't need thousands of file descriptors and buffers of that size.
+    static constexpr size_t SNAPSHOT_BUFFER_SIZE = 64 * 1024;
+
+    int64_t snapshotStartTime;
+    int64_t snapshotEndTime;
+    int numberOfFields;
+    std::string snapshotFilePrefix;
+    SnapshotFormat snapshotFormat;
+
+    // Indexed by symbol id, never resized so the reader can add books while the workers use the existing ones.
+    // A book is created by the reader before the first batch containing its symbol is queued, the queue mutex
+    // makes it visible to the worker.
+    std::vector<std::unique_ptr<SymbolBook>> books;
+    std::vector<std::unique_ptr<OrderBatchQueue>> queues;
+    std::vector<std::vector<Order>> pendingBatches; // batch being filled for each worker (reader thread only)
+    std::vector<std::thread> workers;
+
+    void work(size_t worker) {
+        std::vector<Order> batch;
+        while (queues[worker]->pop(batch)) {
+            for (const Order& order : batch) {
+                SymbolBook& symbolBook = *books[order.symbol];
+                symbolBook.book.processOrder(order, symbolBook.symbol, snapshotStartTime, snapshotEndTime, numberOfFields);
+                symbolBook.ordersProcessed++;
+                symbolBook.lastTimestamp = order.timestamp;
+            }
+        }
+    }
+
+public:
+    // The snapshots of each symbol are written to <snapshotFilePrefix><symbol>.txt (or .bin), an empty prefix disables them.
+    // Like ReadTextFile, a start time of 0 means only the last snapshot (once every order has been processed) is written.
+    BookManager(size_t workerCount, int64_t snapshotStartTime, int64_t snapshotEndTime, int numberOfFields = SNAPSHOT_DEPTH,
+                const std::string& snapshotFilePrefix = "snapshots_", SnapshotFormat snapshotFormat = SnapshotFormat::Text)
+        : snapshotStartTime(snapshotStartTime), snapshotEndTime(snapshotEndTime), numberOfFields(numberOfFields),
+          snapshotFilePrefix(snapshotFilePrefix), snapshotFormat(snapshotFormat), books(static_cast<size_t>(SymbolTable::NO_SYMBOL) + 1) {
+        workerCount = std::max<size_t>(workerCount, 1);
+        for (size_t worker = 0; worker < workerCount; ++worker) {
+            queues.push_back(std::make_unique<OrderBatchQueue>());
+            pendingBatches.emplace_back();
+            pendingBatches.back().reserve(BATCH_SIZE);
+        }
+        for (size_t worker = 0; worker < workerCount; ++worker) {
+            workers.emplace_back(&BookManager::work, this, worker);
+        }
+    }
+
+    ~BookManager() {
+        finish();
+    }
+
+    // Hand an order to the worker of its symbol (called by the thread reading the log)
+    void submit(const Order& order, const SymbolTable& symbols) {
+        if (!books[order.symbol]) {
+            books[order.symbol] = std::make_unique<SymbolBook>();
+            SymbolBook& symbolBook = *books[order.symbol];
+            symbolBook.symbol = symbols.name(order.symbol);
+            if (!snapshotFilePrefix.empty()) {
+                symbolBook.snapshots = std::make_unique<SnapshotWriter>(snapshotFileName(symbolBook.symbol), symbolBook.symbol, snapshotFormat, SNAPSHOT_BUFFER_SIZE,
+                                                                        false, false);
+                // With a single snapshot the writer is only given to the book at the end (see finish)
+                if (snapshotStartTime != 0) {
+                    symbolBook.book.setSnapshotWriter(symbolBook.snapshots.get());
+                }
+            }
+        }
+        size_t worker = order.symbol % queues.size();
+        pendingBatches[worker].push_back(order);
+        if (pendingBatches[worker].size() == BATCH_SIZE) {
+            queues[worker]->push(std::move(pendingBatches[worker]));
+            pendingBatches[worker] = std::vector<Order>();
+            pendingBatches[worker].reserve(BATCH_SIZE);
+        }
+    }
+
+    // Flush the last batches and wait until every order has been processed
+    void finish() {
+        if (workers.empty()) {
+            return;
+        }
+        for (size_t worker = 0; worker < queues.size(); ++worker) {
+            if (!pendingBatches[worker].empty()) {
+                queues[worker]->push(std::move(pendingBatches[worker]));
+                pendingBatches[worker] = std::vector<Order>();
+            }
+            queues[worker]->close();
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+
+        for (auto& symbolBook : books) {
+            if (!symbolBook || !symbolBook->snapshots) {
+                continue;
+            }
+            if (snapshotStartTime == 0 && symbolBook->ordersProcessed > 0) {
+                symbolBook->book.setSnapshotWriter(symbolBook->snapshots.get());
+                symbolBook->book.takeSnapshot(symbolBook->lastTimestamp, symbolBook->symbol, numberOfFields);
+            }
+            symbolBook->snapshots->flush();
+        }
+    }
+
+    // Snapshot file of a symbol
+    std::string snapshotFileName(const std::string& symbol) const {
+        return snapshotFilePrefix + symbol + snapshotFileExtension(snapshotFormat);
+    }
+
+    size_t workerCount() const {
+        return queues.size();
+    }
+
+    // Visit the book of every symbol seen so far, in symbol id order (call finish first)
+    template <typename Visitor>
+    void forEachBook(Visitor visit) {
+        for (auto& symbolBook : books) {
+            if (symbolBook) {
+                visit(*symbolBook);
+            }
+        }
+    }
+};
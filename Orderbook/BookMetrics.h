@@ -0,0 +1,312 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define ORDERBOOK_HAS_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define ORDERBOOK_HAS_TSC 1
+#endif
+
+#include "Order.h"
+
+// Clock of the latency histograms: the time stamp counter where there is one (a few ns to read), steady_clock in ns otherwise
+inline uint64_t readCycleCounter() {
+#ifdef ORDERBOOK_HAS_TSC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Ticks of readCycleCounter per nanosecond, measured once (20 ms) the first time it is needed
+inline double cycleCounterTicksPerNanosecond() {
+#ifdef ORDERBOOK_HAS_TSC
+    static const double ticksPerNanosecond = [] {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t startTicks = readCycleCounter();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        uint64_t endTicks = readCycleCounter();
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<double>(endTicks - startTicks) / elapsed.count();
+    }();
+    return ticksPerNanosecond;
+#else
+    return 1.0;
+#endif
+}
+
+// Counter written by the thread owning the book and readable from any other thread while it runs
+// A single writer doesn't need an atomic increment, a relaxed load and store is as cheap as a plain increment
+class MetricsCounter
+{
+private:
+    std::atomic<uint64_t> value{ 0 };
+
+public:
+    MetricsCounter() = default;
+
+    MetricsCounter(const MetricsCounter& other) : value(other.get()) {
+    }
+
+    MetricsCounter& operator=(const MetricsCounter& other) {
+        value.store(other.get(), std::memory_order_relaxed);
+        return *this;
+    }
+
+    void add(uint64_t amount = 1) {
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    // Keep the largest value seen
+    void raiseTo(uint64_t candidate) {
+        if (candidate > value.load(std::memory_order_relaxed)) {
+            value.store(candidate, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t get() const {
+        return value.load(std::memory_order_relaxed);
+    }
+};
+
+// Histogram of latencies with fixed buckets: 4 buckets per power of two (at most 25% wide), from 0 to 2^64 ticks
+class LatencyHistogram
+{
+public:
+    static constexpr size_t BUCKET_COUNT = 256;
+
+private:
+    MetricsCounter buckets[BUCKET_COUNT];
+    MetricsCounter total;
+    MetricsCounter largest;
+
+    // Number of bits needed to write the value (value > 0)
+    static int bitWidth(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return 64 - __builtin_clzll(value);
+#elif defined(_MSC_VER) && defined(_M_X64)
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return static_cast<int>(index) + 1;
+#else
+        int width = 0;
+        while (value != 0) {
+            value >>= 1;
+            ++width;
+        }
+        return width;
+#endif
+    }
+
+public:
+    static size_t bucketOf(uint64_t ticks) {
+        if (ticks < 4) {
+            return static_cast<size_t>(ticks);
+        }
+        int width = bitWidth(ticks);
+        return static_cast<size_t>(width - 2) * 4 + static_cast<size_t>((ticks >> (width - 3)) & 3);
+    }
+
+    // Largest number of ticks that goes in that bucket
+    static uint64_t bucketUpperBound(size_t bucket) {
+        if (bucket < 4) {
+            return bucket;
+        }
+        int shift = static_cast<int>(bucket / 4) - 1;
+        uint64_t sub = bucket % 4;
+        return ((5 + sub) << shift) - 1;
+    }
+
+    void record(uint64_t ticks) {
+        buckets[bucketOf(ticks)].add();
+        total.add();
+        largest.raiseTo(ticks);
+    }
+
+    uint64_t count() const {
+        return total.get();
+    }
+
+    uint64_t max() const {
+        return largest.get();
+    }
+
+    // Upper bound of the bucket holding that fraction of the recorded latencies (0 if nothing was recorded)
+    uint64_t percentile(double fraction) const {
+        uint64_t wanted = static_cast<uint64_t>(fraction * static_cast<double>(count()));
+        uint64_t seen = 0;
+        for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+            seen += buckets[bucket].get();
+            if (seen > wanted) {
+                return std::min(bucketUpperBound(bucket), max());
+            }
+        }
+        return max();
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+            buckets[bucket].add(other.buckets[bucket].get());
+        }
+        total.add(other.total.get());
+        largest.raiseTo(other.largest.get());
+    }
+};
+
+// Why an event didn't change the book (these used to be printed on std::cout by processOrder)
+enum class RejectReason : uint8_t {
+    OrderNotFound, // CANCEL of an orderId that isn't resting on that side at that price
+    PriceLevelNotFound, // TRADE at a price without any order
+    NotEnoughQuantity, // TRADE of more than the quantity of the level
+    UnknownSideOrCategory, // side or category that isn't BUY/SELL or NEW/CANCEL/TRADE
+    Count
+};
+
+inline const char* rejectReasonToString(RejectReason reason) {
+    switch (reason) {
+    case RejectReason::OrderNotFound: return "order not found";
+    case RejectReason::PriceLevelNotFound: return "price level not found";
+    case RejectReason::NotEnoughQuantity: return "not enough quantity";
+    case RejectReason::UnknownSideOrCategory: return "unknown side or category";
+    default: return "unknown";
+    }
+}
+
+// Counters and latency histograms of one order book, updated by processOrder
+// Every event is counted but only one in LATENCY_SAMPLE_INTERVAL is timed: reading the clock twice costs more than
+// processing a typical event on some machines (rdtsc is ~25 ns in a VM), the samples are taken at a fixed stride so
+// runs stay reproducible
+class BookMetrics
+{
+public:
+    static constexpr uint32_t LATENCY_SAMPLE_INTERVAL = 16;
+
+private:
+    static constexpr size_t CATEGORY_COUNT = static_cast<size_t>(Category::Unknown) + 1;
+
+    uint32_t untilNextSample = 0; // only touched by the thread processing the events
+
+    MetricsCounter events[CATEGORY_COUNT];
+    MetricsCounter rejects[static_cast<size_t>(RejectReason::Count)];
+    MetricsCounter levelsCreated;
+    MetricsCounter levelsDestroyed;
+    MetricsCounter largestQueue;
+    LatencyHistogram latencies[CATEGORY_COUNT]; // in readCycleCounter ticks
+
+public:
+    // True if the next event has to be timed
+    bool sampleNextEvent() {
+        if (untilNextSample == 0) {
+            untilNextSample = LATENCY_SAMPLE_INTERVAL - 1;
+            return true;
+        }
+        --untilNextSample;
+        return false;
+    }
+
+    void eventProcessed(Category category) {
+        events[static_cast<size_t>(category)].add();
+    }
+
+    void eventTimed(Category category, uint64_t ticks) {
+        latencies[static_cast<size_t>(category)].record(ticks);
+    }
+
+    void reject(RejectReason reason) {
+        rejects[static_cast<size_t>(reason)].add();
+    }
+
+    void levelCreated() {
+        levelsCreated.add();
+    }
+
+    void levelDestroyed() {
+        levelsDestroyed.add();
+    }
+
+    void queueDepth(uint32_t orderCount) {
+        largestQueue.raiseTo(orderCount);
+    }
+
+    uint64_t eventCount(Category category) const {
+        return events[static_cast<size_t>(category)].get();
+    }
+
+    uint64_t rejectCount(RejectReason reason) const {
+        return rejects[static_cast<size_t>(reason)].get();
+    }
+
+    uint64_t totalRejects() const {
+        uint64_t total = 0;
+        for (const MetricsCounter& counter : rejects) {
+            total += counter.get();
+        }
+        return total;
+    }
+
+    uint64_t levelsCreatedCount() const {
+        return levelsCreated.get();
+    }
+
+    uint64_t levelsDestroyedCount() const {
+        return levelsDestroyed.get();
+    }
+
+    uint64_t maxQueueDepth() const {
+        return largestQueue.get();
+    }
+
+    const LatencyHistogram& latency(Category category) const {
+        return latencies[static_cast<size_t>(category)];
+    }
+
+    // Add the metrics of another book (to report several books together)
+    void merge(const BookMetrics& other) {
+        for (size_t i = 0; i < CATEGORY_COUNT; ++i) {
+            events[i].add(other.events[i].get());
+            latencies[i].merge(other.latencies[i]);
+        }
+        for (size_t i = 0; i < static_cast<size_t>(RejectReason::Count); ++i) {
+            rejects[i].add(other.rejects[i].get());
+        }
+        levelsCreated.add(other.levelsCreated.get());
+        levelsDestroyed.add(other.levelsDestroyed.get());
+        largestQueue.raiseTo(other.largestQueue.get());
+    }
+
+    void print(std::ostream& out) const {
+        out << "Events:";
+        for (size_t i = 0; i < CATEGORY_COUNT; ++i) {
+            out << " " << categoryToString(static_cast<Category>(i)) << " " << events[i].get();
+        }
+        out << "\nRejects:";
+        for (size_t i = 0; i < static_cast<size_t>(RejectReason::Count); ++i) {
+            out << " " << rejectReasonToString(static_cast<RejectReason>(i)) << " " << rejects[i].get() << (i + 1 < static_cast<size_t>(RejectReason::Count) ? "," : "");
+        }
+        out << "\nLevels: " << levelsCreated.get() << " created, " << levelsDestroyed.get() << " destroyed, max queue depth " << largestQueue.get() << "\n";
+
+        double ticksPerNanosecond = cycleCounterTicksPerNanosecond();
+        auto nanoseconds = [&](uint64_t ticks) {
+            return static_cast<uint64_t>(static_cast<double>(ticks) / ticksPerNanosecond);
+        };
+        out << std::setw(12) << "latency ns" << std::setw(12) << "samples" << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(12) << "max" << "\n";
+        for (size_t i = 0; i < CATEGORY_COUNT; ++i) {
+            const LatencyHistogram& histogram = latencies[i];
+            if (histogram.count() == 0) {
+                continue;
+            }
+            out << std::setw(12) << categoryToString(static_cast<Category>(i)) << std::setw(12) << histogram.count() << std::setw(10) << nanoseconds(histogram.percentile(0.5))
+                << std::setw(10) << nanoseconds(histogram.percentile(0.99)) << std::setw(10) << nanoseconds(histogram.percentile(0.999)) << std::setw(12) << nanoseconds(histogram.max()) << "\n";
+        }
+        out.flush();
+    }
+};
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+#include "Order.h"
+
+// Read only view of the top of the book for other threads (risk, analytics) while the book thread keeps applying events.
+// The book publishes its top N levels after every event into a PublishedDepth (see BasicOrderBook::setDepthPublisher),
+// readers copy the last published view out of it at any time:
+//  - the writer never waits for the readers: publishing is a fixed number of stores, whatever the readers do
+//  - a reader never sees a torn view: it retries if the view changed while it was copying it (seqlock)
+// The view is kept in relaxed atomic words so the concurrent copies are well defined, on x86 and ARM these are plain loads and stores.
+
+constexpr size_t MAX_PUBLISHED_LEVELS = 10;
+
+// Top of the book after an event
+struct DepthView {
+    int64_t timestamp; // timestamp of the event
+    uint64_t updateCount; // number of views published before and including this one
+    uint32_t bidCount;
+    uint32_t askCount;
+    DepthLevel bids[MAX_PUBLISHED_LEVELS]; // best first
+    DepthLevel asks[MAX_PUBLISHED_LEVELS]; // best first
+
+    bool hasBid() const {
+        return bidCount > 0;
+    }
+
+    bool hasAsk() const {
+        return askCount > 0;
+    }
+};
+
+// Best bid and ask only, cheaper to read than the whole view
+struct TopOfBook {
+    int64_t timestamp;
+    uint64_t updateCount;
+    uint32_t bidCount; // 0 if there is no bid (bestBid is then meaningless)
+    uint32_t askCount;
+    DepthLevel bestBid;
+    DepthLevel bestAsk;
+};
+
+static_assert(std::is_trivially_copyable<DepthView>::value && sizeof(DepthView) % sizeof(uint64_t) == 0, "the view is copied as 64 bit words");
+
+// One writer (the book thread), any number of readers
+class PublishedDepth
+{
+private:
+    static constexpr size_t CACHE_LINE = 64;
+    static constexpr size_t WORD_COUNT = sizeof(DepthView) / sizeof(uint64_t);
+
+    // Odd while the writer is updating the words
+    alignas(CACHE_LINE) std::atomic<uint64_t> sequence{ 0 };
+    std::atomic<uint64_t> words[WORD_COUNT] = {};
+    size_t depth;
+    uint64_t publishedCount = 0; // writer only
+
+    // Run copy (relaxed loads of some words) until it saw no update of the writer, the copy is then a consistent view
+    template <typename Copy>
+    void readConsistent(Copy copy) const {
+        for (;;) {
+            uint64_t before = sequence.load(std::memory_order_acquire);
+            if ((before & 1) == 0) {
+                copy();
+                // The loads of copy can't move after the second read of the sequence
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (sequence.load(std::memory_order_relaxed) == before) {
+                    return;
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    void loadWords(uint64_t* destination, size_t first, size_t count) const {
+        for (size_t i = 0; i < count; ++i) {
+            destination[i] = words[first + i].load(std::memory_order_relaxed);
+        }
+    }
+
+public:
+    // Depth of the published views (at most MAX_PUBLISHED_LEVELS). The book keeps the published levels in a view of their own,
+    // any depth can be used whatever the depth of the snapshots.
+    explicit PublishedDepth(size_t depth = 5) : depth(std::min(depth, MAX_PUBLISHED_LEVELS)) {
+    }
+
+    PublishedDepth(const PublishedDepth&) = delete;
+    PublishedDepth& operator=(const PublishedDepth&) = delete;
+
+    size_t levelCount() const {
+        return depth;
+    }
+
+    // Writer: publish the levels of both sides (best first, only the first levelCount are kept)
+    void publish(int64_t timestamp, const std::vector<DepthLevel>& bids, const std::vector<DepthLevel>& asks) {
+        DepthView view;
+        std::memset(&view, 0, sizeof(view)); // the levels after bidCount and askCount are zero
+        view.timestamp = timestamp;
+        view.updateCount = ++publishedCount;
+        view.bidCount = static_cast<uint32_t>(std::min(bids.size(), depth));
+        view.askCount = static_cast<uint32_t>(std::min(asks.size(), depth));
+        std::copy(bids.begin(), bids.begin() + view.bidCount, view.bids);
+        std::copy(asks.begin(), asks.begin() + view.askCount, view.asks);
+        uint64_t source[WORD_COUNT];
+        std::memcpy(source, &view, sizeof(view));
+
+        uint64_t current = sequence.load(std::memory_order_relaxed);
+        sequence.store(current + 1, std::memory_order_relaxed);
+        // The stores of the view can't move before the odd sequence is visible
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORD_COUNT; ++i) {
+            words[i].store(source[i], std::memory_order_relaxed);
+        }
+        sequence.store(current + 2, std::memory_order_release);
+    }
+
+    // Reader: copy the last published view (retries while the writer is updating it)
+    DepthView read() const {
+        uint64_t copy[WORD_COUNT];
+        readConsistent([&] { loadWords(copy, 0, WORD_COUNT); });
+        DepthView view;
+        std::memcpy(&view, copy, sizeof(view));
+        return view;
+    }
+
+    // Reader: best bid and ask of the last published view, only the words holding them are copied
+    TopOfBook readTopOfBook() const {
+        constexpr size_t FRONT_WORDS = (offsetof(DepthView, bids) + sizeof(DepthLevel)) / sizeof(uint64_t); // header and best bid
+        constexpr size_t ASK_WORD = offsetof(DepthView, asks) / sizeof(uint64_t);
+        constexpr size_t LEVEL_WORDS = sizeof(DepthLevel) / sizeof(uint64_t);
+        uint64_t front[FRONT_WORDS];
+        uint64_t bestAsk[LEVEL_WORDS];
+        readConsistent([&] {
+            loadWords(front, 0, FRONT_WORDS);
+            loadWords(bestAsk, ASK_WORD, LEVEL_WORDS);
+        });
+        DepthView view;
+        std::memcpy(&view, front, sizeof(front));
+        TopOfBook top = { view.timestamp, view.updateCount, view.bidCount, view.askCount, view.bids[0], {} };
+        std::memcpy(&top.bestAsk, bestAsk, sizeof(bestAsk));
+        return top;
+    }
+};
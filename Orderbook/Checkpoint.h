@@ -0,0 +1,264 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "Order.h"
+#include "SymbolTable.h"
+#include "MappedFile.h"
+#include "TextLog.h"
+#include "EventLog.h"
+#include "BookImage.h"
+
+// Checkpoints of the order book of one symbol, written by a pre-pass over a log so a time range query can start close to
+// its start time instead of replaying the log from the first line:
+//   CheckpointFileHeader
+//   for each checkpoint: orderCount x CheckpointOrder (every resting order of the book at that point, see forEachRestingOrder)
+//   checkpointCount x CheckpointIndexEntry (the timestamp -> position index, sorted by timestamp)
+// A checkpoint is taken every `interval` lines of the log. The log is assumed to be sorted by timestamp (like the feed it was recorded from).
+// Position in the log: byte offset for a text log, record index for a binary log.
+
+constexpr char CHECKPOINT_FILE_MAGIC[8] = { 'O', 'B', 'C', 'H', 'K', 'P', 'T', '1' };
+constexpr uint32_t CHECKPOINT_FILE_VERSION = 1;
+constexpr uint64_t DEFAULT_CHECKPOINT_INTERVAL = 100000; // lines of the log between two checkpoints
+
+struct CheckpointFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize; // sizeof(Order) when the file was written
+    int64_t ticksPerUnit;
+    uint64_t logLength; // size of the log (bytes or records) when the checkpoints were written, a log that changed isn't used
+    uint64_t interval;
+    uint64_t checkpointCount;
+    uint64_t indexOffset; // offset of the CheckpointIndexEntry table in the file
+};
+
+struct CheckpointIndexEntry {
+    int64_t timestamp; // timestamp of the last line of the log before the checkpoint
+    uint64_t position; // position of the next line in the log
+    int64_t lastOrderTimestamp; // timestamp of the last order of the symbol processed (meaningless if ordersProcessed is 0)
+    uint64_t ordersProcessed; // orders of the symbol processed before the checkpoint
+    uint64_t ordersOffset; // offset of the resting orders in the file
+    uint64_t orderCount;
+};
+
+struct CheckpointOrder {
+    Order order;
+    uint32_t indexed; // see BasicOrderBook::forEachRestingOrder
+    uint32_t reserved;
+};
+
+static_assert(sizeof(CheckpointFileHeader) % alignof(CheckpointOrder) == 0, "resting orders must stay aligned after the header");
+static_assert(sizeof(CheckpointOrder) % alignof(CheckpointIndexEntry) == 0, "index must stay aligned after the resting orders");
+
+// Checkpoints of a symbol go next to the log
+inline std::string checkpointFileName(const std::string& logPath, const std::string& symbol) {
+    return logPath + "." + symbol + ".ckpt";
+}
+
+// Replay the whole log for one symbol and write a checkpoint of its book every `interval` lines
+// Returns the number of checkpoints written
+template <typename Book>
+uint64_t writeCheckpoints(const std::string& logPath, const std::string& symbol, const std::string& checkpointPath, uint64_t interval = DEFAULT_CHECKPOINT_INTERVAL) {
+    interval = std::max<uint64_t>(interval, 1);
+    std::ofstream checkpointFile(checkpointPath, std::ios::binary);
+    if (!checkpointFile.is_open()) {
+        std::cerr << "Unable to open checkpoint file for writing!" << std::endl;
+        return 0;
+    }
+
+    CheckpointFileHeader header = {};
+    std::memcpy(header.magic, CHECKPOINT_FILE_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_FILE_VERSION;
+    header.recordSize = sizeof(Order);
+    header.ticksPerUnit = TICKS_PER_UNIT;
+    header.interval = interval;
+    // The counts are only known at the end, the header is written again once everything else is in the file
+    checkpointFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    Book book;
+    std::vector<CheckpointIndexEntry> index;
+    std::vector<CheckpointOrder> restingOrders;
+    CheckpointIndexEntry current = {};
+    uint64_t fileOffset = sizeof(header);
+
+    auto processOrder = [&](const Order& order, uint16_t symbolId) {
+        current.timestamp = order.timestamp;
+        if (order.symbol == symbolId) {
+            book.processOrder(order, symbol);
+            current.lastOrderTimestamp = order.timestamp;
+            current.ordersProcessed++;
+        }
+    };
+    auto writeCheckpoint = [&](uint64_t position) {
+        restingOrders.clear();
+        book.forEachRestingOrder([&](const Order& order, bool indexed) {
+            restingOrders.push_back({ order, indexed ? 1u : 0u, 0 });
+        });
+        current.position = position;
+        current.ordersOffset = fileOffset;
+        current.orderCount = restingOrders.size();
+        checkpointFile.write(reinterpret_cast<const char*>(restingOrders.data()), static_cast<std::streamsize>(restingOrders.size() * sizeof(CheckpointOrder)));
+        fileOffset += restingOrders.size() * sizeof(CheckpointOrder);
+        index.push_back(current);
+    };
+
+    if (isBinaryLog(logPath)) {
+        BinaryLogReader log;
+        if (!log.open(logPath)) {
+            return 0;
+        }
+        header.logLength = log.size();
+        uint16_t symbolId = log.symbolTable().find(symbol);
+        for (uint64_t record = 0; record < log.size(); ++record) {
+            processOrder(log.begin()[record], symbolId);
+            if ((record + 1) % interval == 0) {
+                writeCheckpoint(record + 1);
+            }
+        }
+    }
+    else {
+        TextLogReader file;
+        if (!file.open(logPath)) {
+            std::cerr << "Unable to open file!" << std::endl;
+            return 0;
+        }
+        header.logLength = file.size();
+        SymbolTable symbols;
+        uint16_t symbolId = symbols.intern(symbol);
+        std::string_view line;
+        while (file.nextLine(line)) {
+            Order order;
+            if (parseOrderLine(line, order, symbols)) {
+                processOrder(order, symbolId);
+            }
+            if (file.lineCount() % interval == 0) {
+                writeCheckpoint(file.offset());
+            }
+        }
+    }
+
+    header.checkpointCount = index.size();
+    header.indexOffset = fileOffset;
+    checkpointFile.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(CheckpointIndexEntry)));
+    checkpointFile.seekp(0);
+    checkpointFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    if (!checkpointFile) {
+        std::cerr << "Error writing checkpoint file!" << std::endl;
+        return 0;
+    }
+    return header.checkpointCount;
+}
+
+// Memory mapped checkpoint file
+class CheckpointReader
+{
+private:
+    MappedFile file;
+    std::vector<CheckpointIndexEntry> index; // the checkpoints of the file that can be restored, sorted by timestamp
+
+public:
+    // Returns false if there is no usable checkpoint file for a log of that length (missing, other version, log changed since)
+    // A checkpoint whose resting orders or log position are outside of their file is skipped, the query starts from an earlier
+    // one (or from the beginning of the log if none is left)
+    bool open(const std::string& checkpointPath, uint64_t logLength) {
+        if (!file.open(checkpointPath)) {
+            return false;
+        }
+        CheckpointFileHeader header;
+        if (file.size() < sizeof(header)) {
+            return false;
+        }
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, CHECKPOINT_FILE_MAGIC, sizeof(header.magic)) != 0 || header.version != CHECKPOINT_FILE_VERSION
+            || header.recordSize != sizeof(Order) || header.ticksPerUnit != TICKS_PER_UNIT) {
+            std::cerr << "Checkpoint file was written with another version of the format, ignored" << std::endl;
+            return false;
+        }
+        if (header.logLength != logLength) {
+            std::cerr << "Log changed since the checkpoints were written, ignored" << std::endl;
+            return false;
+        }
+        if (header.indexOffset > file.size() || (file.size() - header.indexOffset) / sizeof(CheckpointIndexEntry) < header.checkpointCount) {
+            std::cerr << "Checkpoint file is truncated, ignored" << std::endl;
+            return false;
+        }
+        index.clear();
+        index.reserve(header.checkpointCount);
+        const char* entries = file.data() + header.indexOffset;
+        for (uint64_t i = 0; i < header.checkpointCount; ++i) {
+            CheckpointIndexEntry entry;
+            std::memcpy(&entry, entries + i * sizeof(entry), sizeof(entry));
+            // Checked one at a time so a corrupted count can't wrap the end of the orders around
+            bool ordersInFile = entry.ordersOffset >= sizeof(header) && entry.ordersOffset <= file.size()
+                && entry.ordersOffset % alignof(CheckpointOrder) == 0
+                && entry.orderCount <= (file.size() - entry.ordersOffset) / sizeof(CheckpointOrder);
+            bool sorted = index.empty() || entry.timestamp >= index.back().timestamp;
+            if (ordersInFile && entry.position <= logLength && sorted) {
+                index.push_back(entry);
+            }
+        }
+        if (index.size() != header.checkpointCount) {
+            std::cerr << "Checkpoint file has " << header.checkpointCount - index.size() << " corrupted checkpoints, ignored" << std::endl;
+        }
+        return true;
+    }
+
+    // Last checkpoint a query can start from: every line before it has a timestamp before `timestamp` (or equal if inclusive)
+    // Returns nullptr if there is none (the query starts from the beginning of the log)
+    const CheckpointIndexEntry* findLastBefore(int64_t timestamp, bool inclusive) const {
+        auto after = inclusive
+            ? std::upper_bound(index.begin(), index.end(), timestamp, [](int64_t value, const CheckpointIndexEntry& entry) { return value < entry.timestamp; })
+            : std::lower_bound(index.begin(), index.end(), timestamp, [](const CheckpointIndexEntry& entry, int64_t value) { return entry.timestamp < value; });
+        return after == index.begin() ? nullptr : &*(after - 1);
+    }
+
+    // Put the resting orders of the checkpoint in an empty book (a checkpoint of this reader, its orders were checked to be in the file)
+    template <typename Book>
+    void restore(const CheckpointIndexEntry& checkpoint, Book& book) const {
+        const CheckpointOrder* orders = reinterpret_cast<const CheckpointOrder*>(file.data() + checkpoint.ordersOffset);
+        for (uint64_t i = 0; i < checkpoint.orderCount; ++i) {
+            book.restoreOrder(orders[i].order, orders[i].indexed != 0);
+        }
+    }
+};
+
+// Restore the book of a query from the last checkpoint before its window, if the log has a checkpoint file or a saved book image
+// (see BookImage.h, used instead of the checkpoints when it is at least as close to the window)
+// A range query needs every order before its start time, a single snapshot query every order up to its end time
+// Returns false if the query has to start from the beginning of the log, otherwise the book is restored and checkpoint tells where to continue
+template <typename Book>
+bool restoreLastCheckpoint(const std::string& logPath, const std::string& symbol, uint64_t logLength, int64_t snapshotStartTime, int64_t snapshotEndTime,
+                           Book& book, CheckpointIndexEntry& checkpoint) {
+    CheckpointReader checkpoints;
+    const CheckpointIndexEntry* found = nullptr;
+    if (checkpoints.open(checkpointFileName(logPath, symbol), logLength)) {
+        found = snapshotStartTime == 0
+            ? checkpoints.findLastBefore(snapshotEndTime, true)
+            : checkpoints.findLastBefore(snapshotStartTime, false);
+    }
+
+    BookImageReader image;
+    if (image.open(bookImageFileName(logPath, symbol), logLength)) {
+        const BookImageHeader& header = image.getHeader();
+        bool beforeWindow = snapshotStartTime == 0 ? header.timestamp <= snapshotEndTime : header.timestamp < snapshotStartTime;
+        if (beforeWindow && (found == nullptr || header.timestamp >= found->timestamp)) {
+            image.restore(book);
+            checkpoint = { header.timestamp, header.position, header.lastOrderTimestamp, header.ordersProcessed, 0, header.orderCount };
+            return true;
+        }
+    }
+
+    if (found == nullptr) {
+        return false;
+    }
+    checkpoints.restore(*found, book);
+    checkpoint = *found;
+    return true;
+}
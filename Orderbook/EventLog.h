@@ -0,0 +1,194 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <algorithm>
+
+#include "Order.h"
+#include "SymbolTable.h"
+#include "MappedFile.h"
+#include "TextLog.h"
+
+// Binary log format, written once from a text log and then replayed as many times as needed:
+//   BinaryLogHeader
+//   recordCount x Order (32 bytes each, see Order.h)
+//   symbolCount x BinaryLogSymbol (id = position in the table)
+// All the values are little endian. The records start right after the header so a memory mapped file
+// can be read as an array of Order without copying or parsing anything.
+
+constexpr char BINARY_LOG_MAGIC[8] = { 'O', 'B', 'E', 'V', 'E', 'N', 'T', 'S' };
+constexpr uint32_t BINARY_LOG_VERSION = 1;
+
+struct BinaryLogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize; // sizeof(Order) when the file was written
+    int64_t ticksPerUnit; // TICKS_PER_UNIT when the file was written, prices are in ticks
+    uint64_t recordCount;
+    uint64_t symbolCount;
+};
+
+struct BinaryLogSymbol {
+    char name[32]; // null terminated
+};
+
+static_assert(sizeof(BinaryLogHeader) % alignof(Order) == 0, "records must stay aligned after the header");
+
+// Binary logs are recognized by their extension
+inline bool isBinaryLog(const std::string& filePath) {
+    return filePath.size() >= 4 && filePath.compare(filePath.size() - 4, 4, ".bin") == 0;
+}
+
+// Convert a text log (one order per line) to the binary format
+// Returns the number of orders written, lines that can't be parsed are skipped like in ReadTextFile
+inline uint64_t convertLogToBinary(const std::string& txtFilename, const std::string& binFilename) {
+    TextLogReader file;
+    if (!file.open(txtFilename)) {
+        std::cerr << "Unable to open file!" << std::endl;
+        return 0;
+    }
+
+    std::ofstream binaryFile(binFilename, std::ios::binary);
+    if (!binaryFile.is_open()) {
+        std::cerr << "Unable to open binary file for writing!" << std::endl;
+        return 0;
+    }
+
+    BinaryLogHeader header = {};
+    std::memcpy(header.magic, BINARY_LOG_MAGIC, sizeof(header.magic));
+    header.version = BINARY_LOG_VERSION;
+    header.recordSize = sizeof(Order);
+    header.ticksPerUnit = TICKS_PER_UNIT;
+    // The counts are only known at the end, the header is written again once everything else is in the file
+    binaryFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    SymbolTable symbols;
+    std::string_view line;
+    while (file.nextLine(line)) {
+        Order order;
+
+        if (!parseOrderLine(line, order, symbols)) {
+            // A symbol past the last id can't be written, the log is refused instead of losing its orders one by one
+            if (symbols.full() && symbols.find(lineSymbol(line)) == SymbolTable::NO_SYMBOL && !lineSymbol(line).empty()) {
+                std::cerr << "The log has more than " << SymbolTable::NO_SYMBOL << " symbols, it can't be converted!" << std::endl;
+                return 0;
+            }
+            std::cerr << "Error reading line!" << std::endl;
+            continue;
+        }
+
+        binaryFile.write(reinterpret_cast<const char*>(&order), sizeof(Order));
+        header.recordCount++;
+    }
+
+    for (size_t id = 0; id < symbols.size(); ++id) {
+        BinaryLogSymbol symbol = {};
+        const std::string& name = symbols.name(static_cast<uint16_t>(id));
+        std::memcpy(symbol.name, name.data(), std::min(name.size(), sizeof(symbol.name) - 1));
+        binaryFile.write(reinterpret_cast<const char*>(&symbol), sizeof(symbol));
+    }
+    header.symbolCount = symbols.size();
+
+    binaryFile.seekp(0);
+    binaryFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    if (!binaryFile) {
+        std::cerr << "Error writing binary file!" << std::endl;
+        return 0;
+    }
+    return header.recordCount;
+}
+
+// Memory mapped binary log, the orders can be fed to the order book straight from the mapping
+class BinaryLogReader
+{
+private:
+    MappedFile file;
+    const Order* records = nullptr;
+    uint64_t recordCount = 0;
+    SymbolTable symbols;
+
+public:
+    bool open(const std::string& binFilename) {
+        if (!file.open(binFilename)) {
+            std::cerr << "Unable to open binary file for reading!" << std::endl;
+            return false;
+        }
+
+        BinaryLogHeader header;
+        if (file.size() < sizeof(header)) {
+            std::cerr << "Binary file is too small to be an order log!" << std::endl;
+            return false;
+        }
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, BINARY_LOG_MAGIC, sizeof(header.magic)) != 0) {
+            std::cerr << "Not a binary order log!" << std::endl;
+            return false;
+        }
+        if (header.version != BINARY_LOG_VERSION || header.recordSize != sizeof(Order) || header.ticksPerUnit != TICKS_PER_UNIT) {
+            std::cerr << "Binary order log was written with another version of the format, convert the text log again!" << std::endl;
+            return false;
+        }
+        // Counts checked one at a time so a corrupted count can't wrap the size computation around
+        uint64_t available = file.size() - sizeof(header);
+        if (header.recordCount > available / sizeof(Order)
+            || header.symbolCount > (available - header.recordCount * sizeof(Order)) / sizeof(BinaryLogSymbol)) {
+            std::cerr << "Binary order log is truncated!" << std::endl;
+            return false;
+        }
+        if (header.symbolCount > SymbolTable::NO_SYMBOL) {
+            std::cerr << "Binary order log has more symbols than a symbol id can hold!" << std::endl;
+            return false;
+        }
+
+        records = reinterpret_cast<const Order*>(file.data() + sizeof(header));
+        recordCount = header.recordCount;
+
+        // The records are used as they are (the side and category index arrays of the book and of its metrics, the symbol the
+        // symbol table), so they are all checked once here: a file with a value outside of its enum or table is refused
+        for (uint64_t i = 0; i < recordCount; ++i) {
+            const Order& order = records[i];
+            if (static_cast<uint8_t>(order.side) > static_cast<uint8_t>(Side::Unknown)
+                || static_cast<uint8_t>(order.category) > static_cast<uint8_t>(Category::Unknown)
+                || order.symbol >= header.symbolCount) {
+                std::cerr << "Binary order log has an invalid record (number " << i << "), convert the text log again!" << std::endl;
+                records = nullptr;
+                recordCount = 0;
+                return false;
+            }
+        }
+
+        const BinaryLogSymbol* symbolTable = reinterpret_cast<const BinaryLogSymbol*>(records + recordCount);
+        for (uint64_t id = 0; id < header.symbolCount; ++id) {
+            symbols.intern(std::string(symbolTable[id].name, strnlen(symbolTable[id].name, sizeof(symbolTable[id].name))));
+        }
+        // A name given twice would leave the ids after it without a name
+        if (symbols.size() != header.symbolCount) {
+            std::cerr << "Binary order log has a symbol table with duplicate names, convert the text log again!" << std::endl;
+            records = nullptr;
+            recordCount = 0;
+            return false;
+        }
+        return true;
+    }
+
+    const Order* begin() const {
+        return records;
+    }
+
+    const Order* end() const {
+        return records + recordCount;
+    }
+
+    uint64_t size() const {
+        return recordCount;
+    }
+
+    const SymbolTable& symbolTable() const {
+        return symbols;
+    }
+};
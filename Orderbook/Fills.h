@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "Order.h"
+
+// Fills of the matching mode (see BasicOrderBook::setFillBuffer): a NEW order crossing the opposite side trades with the
+// resting orders in price-time priority, each resting order it trades with gives one fill.
+struct Fill {
+    int64_t timestamp; // timestamp of the aggressive order
+    int64_t takerOrderId; // the aggressive NEW order
+    int64_t makerOrderId; // the resting order it traded with
+    int64_t price; // in ticks, price of the resting order
+    int32_t quantity;
+    Side takerSide;
+};
+
+// Buffer the book appends the fills to, allocated once: the consumer reads the fills after each order (or batch of orders)
+// and clears it, the capacity is kept so filling it again never touches the heap. It only grows if more fills than its
+// capacity are produced before it is cleared.
+class FillBuffer
+{
+private:
+    std::vector<Fill> fills;
+    uint64_t fillsAdded = 0;
+
+public:
+    explicit FillBuffer(size_t capacity = 4096) {
+        fills.reserve(capacity);
+    }
+
+    void add(const Fill& fill) {
+        fills.push_back(fill);
+        fillsAdded++;
+    }
+
+    void clear() {
+        fills.clear();
+    }
+
+    size_t size() const {
+        return fills.size();
+    }
+
+    bool empty() const {
+        return fills.empty();
+    }
+
+    const Fill& operator[](size_t i) const {
+        return fills[i];
+    }
+
+    std::vector<Fill>::const_iterator begin() const {
+        return fills.begin();
+    }
+
+    std::vector<Fill>::const_iterator end() const {
+        return fills.end();
+    }
+
+    // Fills added since the buffer was created (clear doesn't reset it)
+    uint64_t totalFills() const {
+        return fillsAdded;
+    }
+};
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <csignal>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// Live feed: the lines of a log that is still being written, read as they arrive instead of from a finished file.
+// Sources (see LiveLogSource::open):
+//   <path>         a log file followed like tail -f: read from its first line, then wait for the lines appended to it
+//   -              stdin, until it is closed
+//   unix:<path>    a local stream socket the feed is published on (connected to as a client), until the publisher closes it
+// Every line is stamped with the time its last byte was read (the ingest time) so the delay until its snapshot reaches
+// the file can be measured.
+
+// Set by Ctrl-C (see requestLiveStop) to stop a live replay cleanly: the lines already read are processed and the snapshots flushed
+inline volatile std::sig_atomic_t liveStopRequested = 0;
+
+inline void requestLiveStop(int) {
+    liveStopRequested = 1;
+}
+
+// Nanoseconds of the steady clock, the clock of the ingest times
+inline int64_t steadyNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class LiveLogSource
+{
+public:
+    enum class Status {
+        Data, // new bytes were read
+        Idle, // nothing new for now, try again
+        End // the stream was closed or can't be read anymore (never for a followed file)
+    };
+
+private:
+    static constexpr size_t READ_SIZE = 64 * 1024; // bytes read at once, bounds the work between two flushes of the snapshots
+    static constexpr int WAIT_MILLISECONDS = 1; // how long fill waits for new bytes before returning Idle
+
+    std::vector<char> buffer;
+    size_t lineStart = 0; // start of the first line not returned yet
+    size_t scanned = 0; // bytes after lineStart known not to contain an end of line
+    size_t used = 0;
+    int64_t lastIngestTime = 0;
+    bool followingFile = false;
+    bool ended = false;
+    uint64_t linesRead = 0;
+#ifdef _WIN32
+    HANDLE handle = INVALID_HANDLE_VALUE;
+    bool ownsHandle = false;
+#else
+    int fileDescriptor = -1;
+    bool ownsDescriptor = false;
+#endif
+
+    // Read whatever is available into the buffer, returns the number of bytes read, 0 if there is nothing for now, -1 at the end
+    long long readSome() {
+        // Keep the unfinished line at the front of the buffer and make room for a full read after it
+        if (lineStart > 0) {
+            std::memmove(buffer.data(), buffer.data() + lineStart, used - lineStart);
+            used -= lineStart;
+            lineStart = 0;
+        }
+        if (buffer.size() - used < READ_SIZE) {
+            buffer.resize(used + READ_SIZE);
+        }
+#ifdef _WIN32
+        // Pipes and consoles block in ::ReadFile until there is something to read
+        DWORD bytesRead = 0;
+        if (!::ReadFile(handle, buffer.data() + used, static_cast<DWORD>(READ_SIZE), &bytesRead, nullptr)) {
+            return followingFile ? 0 : -1;
+        }
+        if (bytesRead == 0) {
+            if (!followingFile) {
+                return -1;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(WAIT_MILLISECONDS));
+            return 0;
+        }
+        return static_cast<long long>(bytesRead);
+#else
+        if (!followingFile) {
+            // Wait a little for the stream so a stop request is noticed even if the feed is quiet
+            pollfd waitFor = { fileDescriptor, POLLIN, 0 };
+            int ready = poll(&waitFor, 1, WAIT_MILLISECONDS);
+            if (ready == 0 || (ready < 0 && errno == EINTR)) {
+                return 0;
+            }
+        }
+        ssize_t bytesRead = ::read(fileDescriptor, buffer.data() + used, READ_SIZE);
+        if (bytesRead < 0) {
+            return errno == EINTR || errno == EAGAIN ? 0 : -1;
+        }
+        if (bytesRead == 0) {
+            if (!followingFile) {
+                return -1;
+            }
+            // End of the file for now, the writer may append more
+            std::this_thread::sleep_for(std::chrono::milliseconds(WAIT_MILLISECONDS));
+            return 0;
+        }
+        return static_cast<long long>(bytesRead);
+#endif
+    }
+
+public:
+    LiveLogSource() = default;
+    LiveLogSource(const LiveLogSource&) = delete;
+    LiveLogSource& operator=(const LiveLogSource&) = delete;
+
+    ~LiveLogSource() {
+        close();
+    }
+
+    // Open "-" (stdin), "unix:<path>" (socket) or a file path, returns false with a message on std::cerr if it can't be opened
+    bool open(const std::string& source) {
+        close();
+        ended = false;
+        followingFile = false;
+        lineStart = scanned = used = 0;
+        linesRead = 0;
+#ifdef _WIN32
+        if (source == "-") {
+            handle = GetStdHandle(STD_INPUT_HANDLE);
+            ownsHandle = false;
+        }
+        else if (source.compare(0, 5, "unix:") == 0) {
+            std::cerr << "UNIX sockets aren't supported on Windows, use a file or stdin" << std::endl;
+            return false;
+        }
+        else {
+            // Shared for writing too, the feed keeps appending to the file
+            handle = CreateFileA(source.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            ownsHandle = true;
+            followingFile = true;
+        }
+        if (handle == INVALID_HANDLE_VALUE || handle == nullptr) {
+            std::cerr << "Unable to open " << source << std::endl;
+            return false;
+        }
+#else
+        if (source == "-") {
+            fileDescriptor = STDIN_FILENO;
+            ownsDescriptor = false;
+        }
+        else if (source.compare(0, 5, "unix:") == 0) {
+            std::string socketPath = source.substr(5);
+            sockaddr_un address = {};
+            address.sun_family = AF_UNIX;
+            if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+                std::cerr << "Invalid socket path " << socketPath << std::endl;
+                return false;
+            }
+            std::memcpy(address.sun_path, socketPath.data(), socketPath.size());
+            fileDescriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+            ownsDescriptor = true;
+            if (fileDescriptor >= 0 && connect(fileDescriptor, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+                close();
+            }
+        }
+        else {
+            fileDescriptor = ::open(source.c_str(), O_RDONLY);
+            ownsDescriptor = true;
+            followingFile = true;
+        }
+        if (fileDescriptor < 0) {
+            std::cerr << "Unable to open " << source << std::endl;
+            return false;
+        }
+#endif
+        buffer.resize(READ_SIZE);
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (handle != INVALID_HANDLE_VALUE && ownsHandle) {
+            CloseHandle(handle);
+        }
+        handle = INVALID_HANDLE_VALUE;
+        ownsHandle = false;
+#else
+        if (fileDescriptor >= 0 && ownsDescriptor) {
+            ::close(fileDescriptor);
+        }
+        fileDescriptor = -1;
+        ownsDescriptor = false;
+#endif
+    }
+
+    // Get the next complete line already read (without its end of line) and the time it was read, returns false if there is none:
+    // call fill to read more. Once the stream has ended the last line is returned even without an end of line.
+    // The line stays valid until the next call to fill.
+    bool nextLine(std::string_view& line, int64_t& ingestTime) {
+        const char* begin = buffer.data() + lineStart;
+        const char* lineEnd = static_cast<const char*>(std::memchr(begin + scanned, '\n', used - lineStart - scanned));
+        if (lineEnd == nullptr) {
+            if (!ended || lineStart == used) {
+                scanned = used - lineStart;
+                return false;
+            }
+            lineEnd = buffer.data() + used; // last line without an end of line
+        }
+        line = std::string_view(begin, static_cast<size_t>(lineEnd - begin));
+        lineStart = lineEnd == buffer.data() + used ? used : static_cast<size_t>(lineEnd - buffer.data()) + 1;
+        scanned = 0;
+        ingestTime = lastIngestTime;
+        ++linesRead;
+        return true;
+    }
+
+    // Read more bytes, waiting a little for them (a few ms at most)
+    Status fill() {
+        if (ended) {
+            return Status::End;
+        }
+        long long bytesRead = readSome();
+        if (bytesRead < 0) {
+            ended = true;
+            return Status::End;
+        }
+        if (bytesRead == 0) {
+            return Status::Idle;
+        }
+        used += static_cast<size_t>(bytesRead);
+        lastIngestTime = steadyNanoseconds();
+        return Status::Data;
+    }
+
+    uint64_t lineCount() const {
+        return linesRead;
+    }
+};
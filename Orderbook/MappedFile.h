@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read only memory mapping of a whole file, the pages are loaded by the OS as they are touched
+class MappedFile
+{
+private:
+    const char* fileData = nullptr;
+    size_t fileSize = 0;
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mappingHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        close();
+    }
+
+    bool open(const std::string& filePath) {
+        close();
+#ifdef _WIN32
+        fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(fileHandle, &size)) {
+            close();
+            return false;
+        }
+        fileSize = static_cast<size_t>(size.QuadPart);
+        if (fileSize == 0) {
+            return true; // nothing to map
+        }
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingHandle == nullptr) {
+            close();
+            return false;
+        }
+        fileData = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+#else
+        fileDescriptor = ::open(filePath.c_str(), O_RDONLY);
+        if (fileDescriptor < 0) {
+            return false;
+        }
+        struct stat fileStat;
+        if (fstat(fileDescriptor, &fileStat) != 0) {
+            close();
+            return false;
+        }
+        fileSize = static_cast<size_t>(fileStat.st_size);
+        if (fileSize == 0) {
+            return true; // nothing to map
+        }
+        void* mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        if (mapping != MAP_FAILED) {
+            // The file is read from the beginning to the end, let the kernel read ahead aggressively
+            madvise(mapping, fileSize, MADV_SEQUENTIAL);
+            fileData = static_cast<const char*>(mapping);
+        }
+#endif
+        if (fileData == nullptr) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (fileData != nullptr) {
+            UnmapViewOfFile(fileData);
+        }
+        if (mappingHandle != nullptr) {
+            CloseHandle(mappingHandle);
+            mappingHandle = nullptr;
+        }
+        if (fileHandle != INVALID_HANDLE_VALUE) {
+            CloseHandle(fileHandle);
+            fileHandle = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (fileData != nullptr) {
+            munmap(const_cast<char*>(fileData), fileSize);
+        }
+        if (fileDescriptor >= 0) {
+            ::close(fileDescriptor);
+            fileDescriptor = -1;
+        }
+#endif
+        fileData = nullptr;
+        fileSize = 0;
+    }
+
+    const char* data() const {
+        return fileData;
+    }
+
+    size_t size() const {
+        return fileSize;
+    }
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <string_view>
+#include <type_traits>
+
+// Prices are stored as an integer number of ticks so that two prices of the same level always compare equal
+// (106.7 and 106.70000001 would otherwise end up in two different levels)
+constexpr int PRICE_DECIMALS = 2; // tick size of 0.01
+
+constexpr int64_t powerOfTen(int exponent) {
+    return exponent == 0 ? 1 : 10 * powerOfTen(exponent - 1);
+}
+
+constexpr int64_t TICKS_PER_UNIT = powerOfTen(PRICE_DECIMALS);
+
+inline int64_t priceToTicks(double price) {
+    return std::llround(price * TICKS_PER_UNIT);
+}
+
+inline double ticksToPrice(int64_t ticks) {
+    return static_cast<double>(ticks) / TICKS_PER_UNIT;
+}
+
+enum class Side : uint8_t {
+    Buy,
+    Sell,
+    Unknown // anything else found in the log, ignored by the order book
+};
+
+enum class Category : uint8_t {
+    New,
+    Cancel,
+    Trade, // (Modify)
+    Unknown // anything else found in the log, ignored by the order book
+};
+
+inline Side parseSide(std::string_view side) {
+    if (side == "BUY") return Side::Buy;
+    if (side == "SELL") return Side::Sell;
+    return Side::Unknown;
+}
+
+inline Category parseCategory(std::string_view category) {
+    if (category == "NEW") return Category::New;
+    if (category == "CANCEL") return Category::Cancel;
+    if (category == "TRADE") return Category::Trade;
+    return Category::Unknown;
+}
+
+inline const char* sideToString(Side side) {
+    switch (side) {
+    case Side::Buy: return "BUY";
+    case Side::Sell: return "SELL";
+    default: return "UNKNOWN";
+    }
+}
+
+inline const char* categoryToString(Category category) {
+    switch (category) {
+    case Category::New: return "NEW";
+    case Category::Cancel: return "CANCEL";
+    case Category::Trade: return "TRADE";
+    default: return "UNKNOWN";
+    }
+}
+
+// Plain fixed size record: it is written as is in the binary log files (see EventLog.h)
+// so the fields are ordered to avoid any padding
+struct Order {
+    int64_t timestamp;
+    int64_t orderId;
+    int64_t price; // in ticks, see priceToTicks
+    int32_t quantity;
+    uint16_t symbol; // id of the symbol (AAPL, GOOG, MSFT, etc. SCS, SCH in this case) in the SymbolTable
+    Side side; // BUY, SELL
+    Category category; // NEW, CANCEL, TRADE (Modify)
+};
+
+static_assert(sizeof(Order) == 32, "Order is stored as a 32 bytes record in binary logs");
+static_assert(std::is_trivially_copyable<Order>::value, "Order is read directly from memory mapped files");
+
+// Handle of a resting order in the OrderPool of its book (see OrderPool.h)
+constexpr uint32_t NO_ORDER = UINT32_MAX;
+
+struct PriceLevel { // orders at the same specific price
+    int quantity = 0; // total quantity resting at that price
+    // FIFO of the orders resting at that price, linked through the nodes of the OrderPool (so a single order can be unlinked in O(1))
+    uint32_t head = NO_ORDER;
+    uint32_t tail = NO_ORDER;
+    uint32_t orderCount = 0; // length of the FIFO
+
+    bool empty() const {
+        return head == NO_ORDER;
+    }
+};
+
+// Custom comparator to sort the order book on the BID side in descending order
+struct CompareBids {
+    constexpr bool operator()(const int64_t& lhs, const int64_t& rhs) const {
+        return lhs > rhs;
+    }
+};
+
+// Custom comparator to sort the order book on the ASK side in ascending order
+struct CompareAsks {
+    constexpr bool operator()(const int64_t& lhs, const int64_t& rhs) const {
+        return lhs < rhs;
+    }
+};
+
+// One price level of a snapshot, the price stays in ticks until the snapshot is written out
+struct DepthLevel {
+    int64_t price;
+    int quantity;
+};
@@ -0,0 +1,590 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <map>
+#include <algorithm>
+#include <iomanip>
+
+#include "Order.h"
+#include "PriceLevels.h"
+#include "OrderPool.h"
+#include "BookMetrics.h"
+#include "SnapshotWriter.h"
+#include "BookView.h"
+#include "Fills.h"
+#include "BookAnalytics.h"
+#include "SnapshotGrid.h"
+
+// Top N price levels of one side of the book (best first), kept in numeric form and updated as the book changes.
+// A quantity change of a level inside the top N is applied in place; a level added or removed inside the top N marks
+// the view dirty and it is rebuilt from the price levels the next time it is read. Changes below the top N cost nothing.
+// The sums of the quantities and notionals of the top N (see BookAnalytics.h) follow the same rules: adjusted by the
+// difference on a quantity change, summed again over the rebuilt array otherwise.
+template <typename Compare>
+class DepthCache
+{
+private:
+    std::vector<DepthLevel> levels;
+    DepthSums sums;
+    size_t depth = 0;
+    bool dirty = true;
+
+public:
+    // The quantity of an existing level changed
+    void quantityChanged(int64_t price, int quantity) {
+        if (dirty) {
+            return;
+        }
+        for (DepthLevel& level : levels) {
+            if (level.price == price) {
+                int64_t change = static_cast<int64_t>(quantity) - level.quantity;
+                sums.quantity += change;
+                sums.notional += price * change;
+                level.quantity = quantity;
+                return;
+            }
+        }
+    }
+
+    // A level was added to or removed from the book
+    void levelAddedOrRemoved(int64_t price) {
+        // Only a level better than (or at) the worst cached one changes the top N, unless the top N isn't full
+        // (an empty top N is never full, so back() is only read when there is a cached level, even with a depth of 0)
+        if (!dirty && (levels.empty() || levels.size() < depth || !Compare()(levels.back().price, price))) {
+            dirty = true;
+        }
+    }
+
+    // Get the top N levels, rebuilding them from the price levels if needed
+    template <typename Levels>
+    const std::vector<DepthLevel>& get(Levels& priceLevels, size_t numberOfFields) {
+        if (dirty || numberOfFields != depth) {
+            depth = numberOfFields;
+            levels.clear();
+            if (depth > 0) {
+                priceLevels.forEachLevel([&](int64_t price, PriceLevel& level) {
+                    levels.push_back({ price, level.quantity });
+                    return levels.size() < depth;
+                });
+            }
+            sums = sumLevels(levels.data(), levels.size());
+            dirty = false;
+        }
+        return levels;
+    }
+
+    // Sums of the levels returned by the last get
+    const DepthSums& getSums() const {
+        return sums;
+    }
+};
+
+// Depth of the snapshots when no other is given
+constexpr int SNAPSHOT_DEPTH = 5;
+
+// One side of the book: its price levels, the index of its resting orders and its top N views.
+// The event handlers of the order book are templates on the side they update, so the BUY and the SELL paths are the same code
+// compiled once for each side with its comparator known at compile time (nothing is decided on the side inside them).
+template <template <typename> class PriceLevels, typename SideCompare, Side BookSide>
+struct BookHalf {
+    using Compare = SideCompare;
+    static constexpr Side side = BookSide;
+
+    // Key: Price (in ticks), Value: Price Level with the total quantity and the FIFO of the orders at that price
+    PriceLevels<Compare> levels;
+
+    // Key: orderId, Value: node of the resting order inside its level's FIFO
+    // Lets CANCEL and TRADE unlink a single order in O(1) instead of scanning the whole price level
+    // One index per side since the feed can reuse the same orderId on the BUY and SELL side
+    OrderIdIndex orderIndex;
+
+    // Resting orders the index doesn't point to: an orderId reused on this side while the older order still rests only
+    // indexes the newest one. While there are some, a CANCEL can't trust the index and looks for the oldest order with
+    // that orderId in the level at its price, like the FIFO scan it replaces did.
+    size_t unindexedOrders = 0;
+
+    // Top N levels, used for the snapshots
+    DepthCache<Compare> depth;
+
+    // Top N levels published to the reader threads (see setDepthPublisher). A view of its own, so a published depth other than
+    // the depth of the snapshots doesn't make each of them rebuild the other's view on every event. It stays dirty, and
+    // costs a test per update, as long as nothing is published.
+    DepthCache<Compare> publishedDepth;
+
+    // The price levels changed, tell both top N views
+    void levelAddedOrRemoved(int64_t price) {
+        depth.levelAddedOrRemoved(price);
+        publishedDepth.levelAddedOrRemoved(price);
+    }
+
+    void quantityChanged(int64_t price, int quantity) {
+        depth.quantityChanged(price, quantity);
+        publishedDepth.quantityChanged(price, quantity);
+    }
+
+    // True if an order of the other side at that price reaches a level of this side at levelPrice
+    // (a BUY order reaches the asks at or below its price, a SELL order the bids at or above its price)
+    static bool reachedBy(int64_t price, int64_t levelPrice) {
+        return !Compare()(price, levelPrice);
+    }
+};
+
+// The order book is parameterized on the container holding the price levels of each side (see PriceLevels.h)
+template <template <typename> class PriceLevels>
+class BasicOrderBook
+{
+private:
+    using Bids = BookHalf<PriceLevels, CompareBids, Side::Buy>;
+    using Asks = BookHalf<PriceLevels, CompareAsks, Side::Sell>;
+    Bids bids; // Buy orders
+    Asks asks; // Sell orders
+
+    // Resting orders of both sides, each price level links its orders in FIFO order through these nodes
+    OrderPool restingOrders;
+
+    // Counters and latency histograms, the errors of the feed are counted here instead of being printed
+    BookMetrics bookMetrics;
+
+    // Where the snapshots go as they are taken (see SnapshotWriter.h), no snapshot is taken without one
+    SnapshotWriter* snapshotWriter = nullptr;
+
+    // Sampling mode: the snapshots are taken on that grid instead of after every event (see SnapshotGrid.h)
+    SnapshotGrid* snapshotGrid = nullptr;
+
+    // Where the top of the book is published for reader threads after every event (see BookView.h), nothing is published without one
+    PublishedDepth* depthPublisher = nullptr;
+
+    // Matching mode: where the fills of the NEW orders crossing the book go (see Fills.h), the book doesn't match orders without one
+    FillBuffer* fillBuffer = nullptr;
+
+    // Trade a NEW order with the resting orders of the opposite side it crosses: best price first, and from the front of the FIFO
+    // inside a level (the same way a TRADE consumes a level), as long as its limit price reaches them.
+    // One fill per resting order traded with. restingQuantity is set to what is left of the order, returns true if some is left to rest.
+    template <typename Opposite>
+    bool matchOrder(const Order& order, Opposite& opposite, int32_t& restingQuantity) {
+        restingQuantity = order.quantity;
+        while (restingQuantity > 0) {
+            int64_t bestPrice = 0;
+            PriceLevel* best = nullptr;
+            opposite.levels.forEachLevel([&](int64_t price, PriceLevel& level) {
+                bestPrice = price;
+                best = &level;
+                return false;
+            });
+            if (best == nullptr || !Opposite::reachedBy(order.price, bestPrice)) {
+                break; // nothing left on the other side at a price the order accepts
+            }
+            while (restingQuantity > 0 && !best->empty()) {
+                uint32_t front = best->head;
+                RestingOrder& maker = restingOrders[front];
+                int32_t quantity = std::min(restingQuantity, maker.quantity);
+                fillBuffer->add({ order.timestamp, order.orderId, maker.orderId, bestPrice, quantity, order.side });
+                maker.quantity -= quantity;
+                best->quantity -= quantity;
+                restingQuantity -= quantity;
+                if (maker.quantity == 0) {
+                    unindexOrder(opposite, front);
+                    restingOrders.unlink(*best, front);
+                    restingOrders.release(front);
+                }
+            }
+            levelChanged(opposite, bestPrice, *best);
+        }
+        return restingQuantity > 0;
+    }
+
+    // After orders left a level: remove it if it is empty (the only other lookup of the level an event can do),
+    // otherwise update its quantity in the top N view
+    template <typename Half>
+    void levelChanged(Half& half, int64_t price, PriceLevel& level) {
+        if (level.empty()) {
+            half.levels.erase(price);
+            half.levelAddedOrRemoved(price);
+            bookMetrics.levelDestroyed();
+        }
+        else {
+            half.quantityChanged(price, level.quantity);
+        }
+    }
+
+    // NEW: the order rests at the back of the FIFO of its price level
+    template <typename Half, typename Opposite>
+    void addOrder(const Order& order, Half& half, Opposite& opposite) {
+        // In matching mode the order first trades with the opposite side it crosses, only what is left of it rests in the book
+        int32_t restingQuantity = order.quantity;
+        if (fillBuffer != nullptr && !matchOrder(order, opposite, restingQuantity)) {
+            return;
+        }
+        // Get the price level of the order, it is created if there is no order at that price in the order book yet
+        PriceLevel& level = half.levels.insert(order.price);
+        if (level.empty()) {
+            half.levelAddedOrRemoved(order.price);
+            bookMetrics.levelCreated();
+        }
+        // Update the quantity of the price level too
+        level.quantity += restingQuantity;
+        half.quantityChanged(order.price, level.quantity);
+        // Append the order to the back of the FIFO and remember where it is so it can be removed in O(1) later
+        uint32_t resting = restingOrders.allocate(order.orderId, order.price, restingQuantity);
+        restingOrders.pushBack(level, resting);
+        bookMetrics.queueDepth(level.orderCount);
+        if (half.orderIndex.find(order.orderId) != NO_ORDER) {
+            half.unindexedOrders++; // the older order with that orderId stays in the book without an index entry
+        }
+        half.orderIndex.set(order.orderId, resting);
+    }
+
+    // CANCEL: remove the order from its price level
+    template <typename Half>
+    void cancelOrder(const Order& order, Half& half) {
+        // Cancel the order by looking up its orderId in the index, if after cancelling the order (deleting it), the FIFO of the level is empty, then delete the order at that price from the order book
+        // If the order doesn't exist in the order book (or rests at another price), then count it as rejected
+        uint32_t resting = NO_ORDER;
+        PriceLevel* level = nullptr;
+        if (half.unindexedOrders == 0) {
+            // Every resting order of this side is indexed: the indexed one is the only order with that orderId
+            resting = half.orderIndex.find(order.orderId);
+            if (resting != NO_ORDER && restingOrders[resting].price == order.price) {
+                level = half.levels.find(order.price);
+            }
+        }
+        else {
+            // A reused orderId can have older orders in the book: the oldest one with that orderId at that price is cancelled
+            level = half.levels.find(order.price);
+            if (level != nullptr) {
+                resting = level->head;
+                while (resting != NO_ORDER && restingOrders[resting].orderId != order.orderId) {
+                    resting = restingOrders[resting].next;
+                }
+            }
+        }
+        if (level == nullptr || resting == NO_ORDER) {
+            bookMetrics.reject(RejectReason::OrderNotFound);
+            return;
+        }
+        // Update the price by substracting the quantity of the order that will be deleted from the quantity of the order at that price
+        level->quantity -= restingOrders[resting].quantity;
+        // Unlink the order from the FIFO, give its node back to the pool and forget about it
+        unindexOrder(half, resting);
+        restingOrders.unlink(*level, resting);
+        restingOrders.release(resting);
+        // Check if the FIFO is empty, if it is, then remove the order at that price from the order book
+        levelChanged(half, order.price, *level);
+    }
+
+    // TRADE (Modify): consume the quantity from the front of the FIFO of the price level
+    template <typename Half>
+    void tradeOrder(const Order& order, Half& half) {
+        // Check if the order exists in the order book by checking the order price (key of the price levels)
+        // if it does, and there are enough quantity at that price, then update the quantity (subtract the traded quantity)
+        // and go through the FIFO of the level and subtract the traded quantity from the front of the queue to the back accordingly
+        // if the quantity at that price in the FIFO reaches 0, then remove the price level from the order book.
+        PriceLevel* level = half.levels.find(order.price);
+        if (level == nullptr) {
+            bookMetrics.reject(RejectReason::PriceLevelNotFound);
+            return;
+        }
+        // Check if there are enough quantity at that price
+        if (level->quantity < order.quantity) {
+            bookMetrics.reject(RejectReason::NotEnoughQuantity);
+            return;
+        }
+        // Update the quantity
+        level->quantity -= order.quantity;
+
+        int removeQuantity = order.quantity;
+
+        while (removeQuantity > 0 && !level->empty()) {
+            uint32_t front = level->head;
+            RestingOrder& frontOrder = restingOrders[front];
+            if (frontOrder.quantity > removeQuantity) {
+                frontOrder.quantity -= removeQuantity;
+                break; // found enough quantity of orders to subtract from (ie: to trade)
+            }
+            // The order at the front of the queue is fully traded/processed, remove it from the order book
+            removeQuantity -= frontOrder.quantity; // Update the removeQuantity to subtract from the next order in the queue
+            unindexOrder(half, front);
+            restingOrders.unlink(*level, front);
+            restingOrders.release(front);
+        }
+        // if the queue is empty, then remove the order at that price from the order book
+        levelChanged(half, order.price, *level);
+    }
+
+    // NEW, CANCEL, TRADE (Modify) cases of one side
+    template <typename Half, typename Opposite>
+    void applyOrder(const Order& order, Half& half, Opposite& opposite) {
+        switch (order.category) {
+        case Category::New:
+            addOrder(order, half, opposite);
+            break;
+        case Category::Cancel:
+            cancelOrder(order, half);
+            break;
+        case Category::Trade:
+            tradeOrder(order, half);
+            break;
+        default:
+            bookMetrics.reject(RejectReason::UnknownSideOrCategory);
+            break;
+        }
+    }
+
+    // Put a resting order back at the back of its price level (see restoreOrder)
+    template <typename Half>
+    void restoreInto(Half& half, const Order& order, bool indexed) {
+        PriceLevel& level = half.levels.insert(order.price);
+        if (level.empty()) {
+            half.levelAddedOrRemoved(order.price);
+        }
+        level.quantity += order.quantity;
+        half.quantityChanged(order.price, level.quantity);
+        uint32_t resting = restingOrders.allocate(order.orderId, order.price, order.quantity);
+        restingOrders.pushBack(level, resting);
+        if (indexed) {
+            half.orderIndex.set(order.orderId, resting);
+        }
+        else {
+            half.unindexedOrders++;
+        }
+    }
+
+    // Create a level of a saved book with its orders (see restoreLevel)
+    template <typename Half, typename SavedOrder>
+    void restoreLevelInto(Half& half, int64_t price, const SavedOrder* orders, uint32_t orderCount) {
+        PriceLevel& level = half.levels.insert(price);
+        half.levelAddedOrRemoved(price);
+        uint32_t node = restingOrders.appendLevel(level, orderCount);
+        for (uint32_t i = 0; i < orderCount; ++i, ++node) {
+            RestingOrder& resting = restingOrders[node];
+            resting.orderId = orders[i].orderId;
+            resting.price = price;
+            resting.quantity = orders[i].quantity;
+            level.quantity += orders[i].quantity;
+            if (orders[i].indexed != 0) {
+                half.orderIndex.set(orders[i].orderId, node);
+            }
+            else {
+                half.unindexedOrders++;
+            }
+        }
+    }
+
+    // Resting orders of one side, best price first (see forEachRestingOrder)
+    template <typename Half, typename Visitor>
+    void forEachRestingOrderOf(Half& half, Visitor& visit) {
+        half.levels.forEachLevel([&](int64_t, PriceLevel& level) {
+            for (uint32_t resting = level.head; resting != NO_ORDER; resting = restingOrders[resting].next) {
+                const RestingOrder& node = restingOrders[resting];
+                visit(Order{ 0, node.orderId, node.price, node.quantity, 0, Half::side, Category::New }, half.orderIndex.find(node.orderId) == resting);
+            }
+            return true;
+        });
+    }
+
+    template <typename Half>
+    void printSide(Half& half) {
+        half.levels.forEachLevel([this](int64_t price, PriceLevel& level) {
+            std::cout << "Price: " << ticksToPrice(price) << ", Quantity: " << level.quantity;
+            std::cout << ", Orders: ";
+            std::cout << "[";
+            for (uint32_t resting = level.head; resting != NO_ORDER; resting = restingOrders[resting].next) {
+                std::cout << restingOrders[resting].quantity << " (" << "id:" << restingOrders[resting].orderId << "), ";
+            }
+            std::cout << " ]";
+            std::cout << std::endl;
+            return true;
+        });
+    }
+    
+ public:
+    // Process the order and update the order book accordingly
+    // Each event looks its price level up once (and erases it if it leaves it empty), the side picks the code compiled for that side
+    void processOrder(const Order& order, const std::string& symbol, int64_t snapshotStartTime = 0, int64_t snapshotEndTime = 0, int numberOfFields = SNAPSHOT_DEPTH) {
+        // Sampling mode: the book before this event is the book at every grid point before it
+        if (snapshotGrid != nullptr) {
+            takeSampledSnapshots(order.timestamp - 1, symbol, numberOfFields);
+        }
+
+        bool timed = bookMetrics.sampleNextEvent();
+        uint64_t startTicks = timed ? readCycleCounter() : 0;
+        switch (order.side) {
+        case Side::Buy:
+            applyOrder(order, bids, asks);
+            break;
+        case Side::Sell:
+            applyOrder(order, asks, bids);
+            break;
+        default:
+            bookMetrics.reject(RejectReason::UnknownSideOrCategory);
+            break;
+        }
+        // Count the event and, if it is sampled, how long it took to update the book (the snapshot isn't included)
+        bookMetrics.eventProcessed(order.category);
+        if (timed) {
+            bookMetrics.eventTimed(order.category, readCycleCounter() - startTicks);
+        }
+
+        // Write a snapshot of the order book if the order is between startTime and endTime (unless the snapshots are sampled)
+        if (snapshotWriter != nullptr && snapshotGrid == nullptr && order.timestamp >= snapshotStartTime && order.timestamp <= snapshotEndTime) {
+            takeSnapshot(order.timestamp, symbol, numberOfFields);
+        }
+
+        // Publish the new top of the book to the reader threads
+        if (depthPublisher != nullptr) {
+            size_t depth = depthPublisher->levelCount();
+            depthPublisher->publish(order.timestamp, bids.publishedDepth.get(bids.levels, depth), asks.publishedDepth.get(asks.levels, depth));
+        }
+    }
+
+    // Metrics of the book, can be read from another thread while the book is being updated
+    const BookMetrics& getMetrics() const {
+        return bookMetrics;
+    }
+
+    // Send the snapshots to that writer from now on (nullptr to stop taking snapshots)
+    void setSnapshotWriter(SnapshotWriter* writer) {
+        snapshotWriter = writer;
+    }
+
+    // Sampling mode: from now on the snapshots are taken at the points of that grid instead of after every event between
+    // the start and end time (nullptr goes back to a snapshot after every event). The replay calls takeSampledSnapshots
+    // when it stops, for the grid points after the last event of the symbol.
+    void setSnapshotGrid(SnapshotGrid* grid) {
+        snapshotGrid = grid;
+    }
+
+    // Sampling mode: write the snapshots of the grid points up to that timestamp (included) not written yet, with the book as it is now
+    void takeSampledSnapshots(int64_t timestamp, const std::string& symbol, int numberOfFields = SNAPSHOT_DEPTH) {
+        if (snapshotGrid != nullptr && snapshotWriter != nullptr) {
+            snapshotGrid->takeUntil(timestamp, [&](int64_t point) {
+                takeSnapshot(point, symbol, numberOfFields);
+            });
+        }
+    }
+
+    // Publish the top of the book to that view after every event from now on (nullptr to stop), other threads can read it meanwhile
+    void setDepthPublisher(PublishedDepth* publisher) {
+        depthPublisher = publisher;
+    }
+
+    // Matching mode: from now on a NEW order crossing the opposite side trades with it and its fills are added to that buffer,
+    // only what is left of the order rests in the book (nullptr goes back to resting every NEW order as it is, like the recorded feeds need)
+    void setFillBuffer(FillBuffer* fills) {
+        fillBuffer = fills;
+    }
+
+    // Write a snapshot of the current top N bids and asks with that timestamp
+    void takeSnapshot(int64_t timestamp, const std::string& symbol, int numberOfFields = SNAPSHOT_DEPTH) {
+        if (snapshotWriter != nullptr) {
+            const std::vector<DepthLevel>& topBids = getTopBids(numberOfFields);
+            const std::vector<DepthLevel>& topAsks = getTopAsks(numberOfFields);
+            if (snapshotWriter->hasAnalyticsColumns()) {
+                BookAnalytics analytics = getAnalytics(numberOfFields);
+                snapshotWriter->write(timestamp, symbol, topBids.data(), topBids.size(), topAsks.data(), topAsks.size(), &analytics);
+            }
+            else {
+                snapshotWriter->write(timestamp, symbol, topBids, topAsks);
+            }
+        }
+    }
+
+    // Remove the index entry of a resting order that is about to leave its price level
+    // The entry is only dropped if it still points to this node (a reused orderId points to the newest order)
+    template <typename Half>
+    void unindexOrder(Half& half, uint32_t resting) {
+        int64_t orderId = restingOrders[resting].orderId;
+        if (half.orderIndex.find(orderId) == resting) {
+            half.orderIndex.erase(orderId);
+        }
+        else {
+            half.unindexedOrders--;
+        }
+    }
+
+    // Visit every resting order, bids then asks, from the best price to the worst one and in FIFO order inside a level
+    // visit(order, indexed): indexed is false for an order whose orderId was reused on the same side (only the newest one is indexed)
+    // The order is given with its remaining quantity, its timestamp and symbol aren't kept by the book (0)
+    // Feeding the orders to restoreOrder in that order rebuilds the same book (used by the checkpoints, see Checkpoint.h)
+    template <typename Visitor>
+    void forEachRestingOrder(Visitor visit) {
+        forEachRestingOrderOf(bids, visit);
+        forEachRestingOrderOf(asks, visit);
+    }
+
+    // Put a resting order back at the back of its price level, as given by forEachRestingOrder
+    void restoreOrder(const Order& order, bool indexed) {
+        if (order.side == Side::Buy) {
+            restoreInto(bids, order, indexed);
+        }
+        else if (order.side == Side::Sell) {
+            restoreInto(asks, order, indexed);
+        }
+    }
+
+    // Bulk restore of a saved book (see BookImage.h): make room for that many resting orders on each side before restoreLevel
+    void reserveRestingOrders(size_t bidOrders, size_t askOrders) {
+        restingOrders.reserve(bidOrders + askOrders);
+        bids.orderIndex.reserve(bids.orderIndex.size() + bidOrders);
+        asks.orderIndex.reserve(asks.orderIndex.size() + askOrders);
+    }
+
+    // Bulk restore of a saved book: create the level at that price with its orders in FIFO order (orderId, quantity and
+    // indexed like forEachRestingOrder gives them), the level must not exist yet. One insert for the level and its
+    // orders linked in place instead of an insert and a pushBack for every order (restoreOrder).
+    template <typename SavedOrder>
+    void restoreLevel(Side side, int64_t price, const SavedOrder* orders, uint32_t orderCount) {
+        if (orderCount == 0) {
+            return;
+        }
+        if (side == Side::Buy) {
+            restoreLevelInto(bids, price, orders, orderCount);
+        }
+        else if (side == Side::Sell) {
+            restoreLevelInto(asks, price, orders, orderCount);
+        }
+    }
+
+    void printOrderBook() {
+        // Print the order book of each side, and the orders of each level
+        std::cout << "BID SIDE" << std::endl;
+        printSide(bids);
+
+        std::cout << "\n";
+
+        std::cout << "ASK SIDE" << std::endl;
+        printSide(asks);
+    }
+
+    // Get the top n bids from the order book. Used for snapshots
+    const std::vector<DepthLevel>& getTopBids(int numberOfFields) {
+        // Top n bids (first n price levels if they exist, otherwise the minimum number of levels that exist), best price first
+        return bids.depth.get(bids.levels, static_cast<size_t>(std::max(numberOfFields, 0)));
+    }
+
+    // Get the top n asks from the order book. Used for snapshots
+    const std::vector<DepthLevel>& getTopAsks(int numberOfFields) {
+        // Top n asks (first n price levels if they exist, otherwise the minimum number of levels that exist), best price first
+        return asks.depth.get(asks.levels, static_cast<size_t>(std::max(numberOfFields, 0)));
+    }
+
+    // Mid, microprice, imbalance and VWAP of the top n levels of each side (see BookAnalytics.h)
+    // O(1) from the running sums of the top n, unless the top n levels changed since they were last read
+    BookAnalytics getAnalytics(int numberOfFields) {
+        const std::vector<DepthLevel>& topBids = getTopBids(numberOfFields);
+        const std::vector<DepthLevel>& topAsks = getTopAsks(numberOfFields);
+        return computeBookAnalytics(topBids.empty() ? nullptr : &topBids.front(), bids.depth.getSums(),
+                                    topAsks.empty() ? nullptr : &topAsks.front(), asks.depth.getSums());
+    }
+};
+
+// Order book with its price levels in std::map (red-black trees)
+using OrderBook = BasicOrderBook<MapPriceLevels>;
+// Order book with its price levels in flat arrays indexed by tick (O(1) lookup and top of book)
+using LadderOrderBook = BasicOrderBook<LadderPriceLevels>;
+// Order book with its price levels in a sorted vector, the smallest book for a process holding thousands of symbols
+using FlatOrderBook = BasicOrderBook<FlatPriceLevels>;
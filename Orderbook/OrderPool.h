@@ -0,0 +1,292 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <algorithm>
+
+#include "Order.h"
+
+// Memory of the order book: the resting orders live in a pool of small fixed size nodes, the orderId index is an open
+// addressing table and the std::map levels recycle their nodes. Everything grows to the largest size the book reaches
+// and is reused afterwards, so once a replay is warmed up processing an order doesn't touch the heap.
+
+// One order resting in a price level. The side and the price level are known from where the order is found,
+// the price is kept so a CANCEL can check it in O(1). The timestamp of the order isn't needed once it rests in the book.
+struct RestingOrder {
+    int64_t orderId;
+    int64_t price; // in ticks
+    int32_t quantity;
+    uint32_t previous; // towards the front of the FIFO of the level, NO_ORDER for the first order
+    uint32_t next; // towards the back of the FIFO of the level, also links the free nodes together
+};
+
+static_assert(sizeof(RestingOrder) <= 32, "a resting order node should stay small");
+
+// Nodes of the resting orders, addressed by a 32 bit handle so the vector can grow without invalidating them
+// A released node goes to a free list and is given back by the next allocate
+class OrderPool
+{
+private:
+    std::vector<RestingOrder> nodes;
+    uint32_t freeHead = NO_ORDER;
+
+public:
+    uint32_t allocate(int64_t orderId, int64_t price, int32_t quantity) {
+        uint32_t node = freeHead;
+        if (node != NO_ORDER) {
+            freeHead = nodes[node].next;
+        }
+        else {
+            node = static_cast<uint32_t>(nodes.size());
+            nodes.emplace_back();
+        }
+        nodes[node] = { orderId, price, quantity, NO_ORDER, NO_ORDER };
+        return node;
+    }
+
+    void release(uint32_t node) {
+        nodes[node].next = freeHead;
+        freeHead = node;
+    }
+
+    RestingOrder& operator[](uint32_t node) {
+        return nodes[node];
+    }
+
+    const RestingOrder& operator[](uint32_t node) const {
+        return nodes[node];
+    }
+
+    // Append the node at the back of the FIFO of the level
+    void pushBack(PriceLevel& level, uint32_t node) {
+        nodes[node].previous = level.tail;
+        nodes[node].next = NO_ORDER;
+        if (level.tail != NO_ORDER) {
+            nodes[level.tail].next = node;
+        }
+        else {
+            level.head = node;
+        }
+        level.tail = node;
+        level.orderCount++;
+    }
+
+    // Remove the node from the FIFO of the level (the node itself isn't released)
+    void unlink(PriceLevel& level, uint32_t node) {
+        RestingOrder& resting = nodes[node];
+        if (resting.previous != NO_ORDER) {
+            nodes[resting.previous].next = resting.next;
+        }
+        else {
+            level.head = resting.next;
+        }
+        if (resting.next != NO_ORDER) {
+            nodes[resting.next].previous = resting.previous;
+        }
+        else {
+            level.tail = resting.previous;
+        }
+        level.orderCount--;
+    }
+
+    // Bulk restore: create count nodes at the end of the pool, linked in that order as the whole FIFO of an empty level
+    // Returns the first one, the nodes follow each other and the caller sets their orderId, price and quantity
+    uint32_t appendLevel(PriceLevel& level, uint32_t count) {
+        if (count == 0) {
+            return NO_ORDER;
+        }
+        uint32_t first = static_cast<uint32_t>(nodes.size());
+        nodes.resize(nodes.size() + count);
+        for (uint32_t i = 0; i < count; ++i) {
+            nodes[first + i].previous = i == 0 ? NO_ORDER : first + i - 1;
+            nodes[first + i].next = i + 1 == count ? NO_ORDER : first + i + 1;
+        }
+        level.head = first;
+        level.tail = first + count - 1;
+        level.orderCount = count;
+        return first;
+    }
+
+    // Make room for that many more nodes
+    void reserve(size_t count) {
+        nodes.reserve(nodes.size() + count);
+    }
+
+    // Nodes ever allocated (in use or free)
+    size_t capacity() const {
+        return nodes.size();
+    }
+};
+
+// Hash table from orderId to the node of the resting order, open addressing with linear probing
+// Removing an entry shifts the following entries of its cluster back, so there are no tombstones and lookups stay short
+class OrderIdIndex
+{
+private:
+    // Power of two, small so a book with a handful of orders stays small (the table doubles as the book grows)
+    static constexpr size_t INITIAL_CAPACITY = 64;
+
+    struct Slot {
+        int64_t orderId;
+        uint32_t node; // NO_ORDER if the slot is empty
+    };
+
+    std::vector<Slot> slots;
+    size_t count = 0;
+
+    size_t home(int64_t orderId) const {
+        uint64_t hash = static_cast<uint64_t>(orderId) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(hash ^ (hash >> 32)) & (slots.size() - 1);
+    }
+
+    void grow() {
+        std::vector<Slot> oldSlots(std::max(slots.size() * 2, INITIAL_CAPACITY), Slot{ 0, NO_ORDER });
+        oldSlots.swap(slots);
+        count = 0;
+        for (const Slot& slot : oldSlots) {
+            if (slot.node != NO_ORDER) {
+                set(slot.orderId, slot.node);
+            }
+        }
+    }
+
+public:
+    // Node of the order, NO_ORDER if the orderId isn't in the index
+    uint32_t find(int64_t orderId) const {
+        if (slots.empty()) {
+            return NO_ORDER;
+        }
+        for (size_t i = home(orderId); slots[i].node != NO_ORDER; i = (i + 1) & (slots.size() - 1)) {
+            if (slots[i].orderId == orderId) {
+                return slots[i].node;
+            }
+        }
+        return NO_ORDER;
+    }
+
+    // Insert the orderId or point it to another node
+    void set(int64_t orderId, uint32_t node) {
+        // Kept at most half full
+        if ((count + 1) * 2 > slots.size()) {
+            grow();
+        }
+        size_t i = home(orderId);
+        while (slots[i].node != NO_ORDER && slots[i].orderId != orderId) {
+            i = (i + 1) & (slots.size() - 1);
+        }
+        if (slots[i].node == NO_ORDER) {
+            ++count;
+        }
+        slots[i] = { orderId, node };
+    }
+
+    void erase(int64_t orderId) {
+        if (slots.empty()) {
+            return;
+        }
+        size_t mask = slots.size() - 1;
+        size_t hole = home(orderId);
+        while (slots[hole].node != NO_ORDER && slots[hole].orderId != orderId) {
+            hole = (hole + 1) & mask;
+        }
+        if (slots[hole].node == NO_ORDER) {
+            return;
+        }
+        --count;
+        // Move back every following entry of the cluster that can't be found anymore with a hole before it
+        for (size_t i = (hole + 1) & mask; slots[i].node != NO_ORDER; i = (i + 1) & mask) {
+            size_t wanted = home(slots[i].orderId);
+            // The entry can fill the hole if its home isn't between the hole (excluded) and its slot (included), cyclically
+            if (((i - wanted) & mask) >= ((i - hole) & mask)) {
+                slots[hole] = slots[i];
+                hole = i;
+            }
+        }
+        slots[hole].node = NO_ORDER;
+    }
+
+    // Make room for that many entries so inserting them doesn't grow the table
+    void reserve(size_t entries) {
+        while (slots.size() < entries * 2) {
+            grow();
+        }
+    }
+
+    size_t size() const {
+        return count;
+    }
+};
+
+// Allocator for node based containers (the std::map of MapPriceLevels): the freed nodes are kept in a free list of the
+// thread and handed out again, so a map that keeps inserting and erasing levels stops calling operator new.
+// The free list only holds nodes of one size (the T the allocator is rebound to), it is released when the thread exits.
+template <typename T>
+class PoolAllocator
+{
+private:
+    struct FreeNode {
+        FreeNode* next;
+    };
+
+    struct FreeList {
+        FreeNode* head = nullptr;
+
+        ~FreeList() {
+            while (head != nullptr) {
+                FreeNode* next = head->next;
+                ::operator delete(head);
+                head = next;
+            }
+        }
+    };
+
+    static FreeList& freeList() {
+        thread_local FreeList list;
+        return list;
+    }
+
+public:
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        if (n != 1) {
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+        FreeList& list = freeList();
+        if (list.head != nullptr) {
+            FreeNode* node = list.head;
+            list.head = node->next;
+            return reinterpret_cast<T*>(node);
+        }
+        return static_cast<T*>(::operator new(std::max(sizeof(T), sizeof(FreeNode))));
+    }
+
+    void deallocate(T* pointer, size_t n) noexcept {
+        if (n != 1) {
+            ::operator delete(pointer);
+            return;
+        }
+        FreeList& list = freeList();
+        FreeNode* node = reinterpret_cast<FreeNode*>(pointer);
+        node->next = list.head;
+        list.head = node;
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&) noexcept {
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&) noexcept {
+    return false;
+}
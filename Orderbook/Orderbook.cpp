@@ -3,508 +3,589 @@
 #include <fstream>
 #include <string>
 #include <vector>
-#include <unordered_map>
 #include <sstream>
-#include <map>
+#include <string_view>
+#include <chrono>
+#include <thread>
 #include <algorithm>
-#include <iomanip>
-
-struct Order {
-    int64_t timestamp;
-    int64_t orderId;
-    std::string symbol; // AAPL, GOOG, MSFT, etc. (SCS, SCH in this case)
-    std::string side; // BUY, SELL
-    std::string category; // NEW, CANCEL, TRADE (Modify)
-    double price; 
-    int quantity;
-    std::vector<Order> samePriceOrders; // Vector of quantity of orders with the same price
-    
+#include <cstring>
+
+#include "OrderBook.h"
+#include "EventLog.h"
+#include "TextLog.h"
+#include "BookManager.h"
+#include "Checkpoint.h"
+#include "Pipeline.h"
+#include "LiveFeed.h"
+#include "BatchReplay.h"
+
+
+// Which container the order book uses for its price levels (see PriceLevels.h)
+enum class BookType {
+    Map, // std::map, works for any range of prices
+    Ladder, // flat array indexed by tick, faster when prices stay within a reasonable range
+    Flat // sorted vector, the smallest book when a process holds thousands of symbols with few orders each
 };
 
-struct PriceLevel { // orders at the same specific price
-    int quantity;
-    int orderId;
-    //std::vector<Order> order;
-};
+// "map", "ladder" or "flat", false if the name isn't one of them
+bool parseBookType(const std::string& name, BookType& bookType) {
+    if (name == "map") bookType = BookType::Map;
+    else if (name == "ladder") bookType = BookType::Ladder;
+    else if (name == "flat") bookType = BookType::Flat;
+    else return false;
+    return true;
+}
 
-// Custom comparator to sort the order book on the BID side in descending order
-struct CompareBids {
-    bool operator()(const double& lhs, const double& rhs) const {
-        return lhs > rhs;
-    }
-};
+// Snapshots of the single symbol modes go to snapshots.txt (or snapshots.bin)
+std::string snapshotFileName(SnapshotFormat snapshotFormat) {
+    return std::string("snapshots") + snapshotFileExtension(snapshotFormat);
+}
 
-// Custom comparator to sort the order book on the ASK side in ascending order
-struct CompareAsks {
-    bool operator()(const double& lhs, const double& rhs) const {
-        return lhs < rhs;
+// Print the order book, then write the last snapshot if only one is wanted (the others were written as they were taken)
+// and the metrics of the book (events, rejected events, latencies)
+template <typename Book>
+void outputOrderBook(Book& orderbook, SnapshotWriter& snapshots, const std::string& symbol, int64_t snapshotStartTime, bool anyOrderProcessed, int64_t lastTimestamp, int numberOfFields) {
+    orderbook.printOrderBook();
+    std::cout << "\n\n";
+    if (snapshotStartTime == 0 && anyOrderProcessed) { // if we want to output the last snapshot at snapshotEndTime (only one time is given which is the end time)
+        orderbook.setSnapshotWriter(&snapshots);
+        orderbook.takeSnapshot(lastTimestamp, symbol, numberOfFields);
     }
-};
-
-struct Snapshot {
-    int64_t timestamp;
-    std::string symbol;
-    std::vector<std::string> bidSnapshots;
-    std::vector<std::string> askSnapshots;
-};
+    snapshots.flush();
+    std::cout << snapshots.recordCount() << " snapshots written" << std::endl;
+    std::cout << "\n";
+    orderbook.getMetrics().print(std::cout);
+}
 
-class OrderBook
+// With pipelined, the lines are parsed and the snapshots formatted on their own threads (see Pipeline.h), the output is the same
+// With analyticsColumns, the snapshots also get the mid, microprice, imbalance and VWAP of each side of the book (see BookAnalytics.h)
+// With a sampleInterval (ns), a range query takes its snapshots every sampleInterval from the start time instead of after every order (see SnapshotGrid.h)
+template <typename Book>
+void ReadTextFile(const std::string& filePath, const std::string& symbol, int64_t snapshotStartTime=0, int64_t snapshotEndTime=0, SnapshotFormat snapshotFormat=SnapshotFormat::Text,
+              bool pipelined=false, bool analyticsColumns=false, int64_t sampleInterval=0)
 {
-private:
-    // Key: Price, Value: Orders that also contain orders of the same price (unprocessed) <=> Price Level
-    std::map<double, Order, CompareBids> bids; // Buy orders
-    std::map<double, Order, CompareAsks> asks; // Sell orders
+    Book orderbook;
+    // The snapshots are written to the file as they are taken
+    // With a single snapshot (no start time) the book only gets the writer once the orders are processed (see outputOrderBook)
+    // The pipelined replay hands the snapshots to its formatter thread instead of giving the writer to the book
+    SnapshotWriter snapshots(snapshotFileName(snapshotFormat), symbol, snapshotFormat, SnapshotWriter::DEFAULT_BUFFER_SIZE, analyticsColumns);
+    SnapshotGrid snapshotGrid(snapshotStartTime, snapshotEndTime, snapshotStartTime != 0 ? sampleInterval : 0);
+    if (snapshotStartTime != 0 && !pipelined) {
+        orderbook.setSnapshotWriter(&snapshots);
+        if (snapshotGrid.enabled()) {
+            orderbook.setSnapshotGrid(&snapshotGrid);
+        }
+    }
+    bool anyOrderProcessed = false;
+    int64_t lastTimestamp = 0;
+    SymbolTable symbols;
+    // Only the orders of that symbol go in the order book, the others are skipped
+    uint16_t symbolId = symbols.intern(symbol);
+    int numberOfFields = SNAPSHOT_DEPTH; // can be modified to get more or less fields for the snapshots
+    // The file is memory mapped and parsed in place (see TextLog.h)
+    TextLogReader file;
+    if (!file.open(filePath)) {
+        std::cerr << "Unable to open file!" << std::endl;
+        //return 1;
+    }
 
-    // Create a vector of snapshots that we will output to a file later after processing the whole order book
-    std::vector<Snapshot> snapshots;
-    
- public:
-    // Process the order and update the order book accordingly
-    void processOrder(const Order& order, std::string symbol, int64_t snapshotStartTime = 0, int64_t snapshotEndTime = 0, int numberOfFields = 5) {
-        if (order.side == "BUY") {
-            // NEW, CANCEL, TRADE (Modify) cases
-            if (order.category == "NEW") {
-                // Case #1: Order at that price doesn't exist in the order book (BID side)
-                if (bids.find(order.price) == bids.end()) {
-                    // Add the order price as key, and the quantity to the samePriceOrders vector too
-                    bids[order.price] = order;
-                    bids[order.price].samePriceOrders.push_back(order);
-                }
-                // Case #2: Order at that price already exists in the order book, so add it to the samePriceOrders vector
-                else {
-                    // Update the quantity of the order too
-                    bids[order.price].quantity += order.quantity;
-                    bids[order.price].samePriceOrders.push_back(order);
-                }
-            }
+    std::vector<Order> orders;
+    std::string_view line;
 
-            else if (order.category == "CANCEL") {
-                // Cancel the order at that price by checking orderId with the samePriceOrders vector orderIds, if after cancelling the order (deleting it), the size of the vector is 0, then delete the order at that price from the order book
-                // If the order doesn't exist in the order book, then throw an error
-                if (bids.find(order.price) != bids.end()) {
-                    // Check if the orderId exists in the samePriceOrders vector
-                    auto it = std::find_if(bids[order.price].samePriceOrders.begin(), bids[order.price].samePriceOrders.end(), [&order](const Order& o) {return o.orderId == order.orderId; });
-                    if (it != bids[order.price].samePriceOrders.end()) {
-                        // Update the price by substracting the quantity of the order that will be deleted from the quantity of the order at that price
-                        bids[order.price].quantity -= it->quantity;
-                        // Remove the order from the samePriceOrders vector
-                        bids[order.price].samePriceOrders.erase(it);
-                        // Check if the size of the samePriceOrders vector is 0, if it is, then remove the order at that price from the order book
-                        if (bids[order.price].samePriceOrders.size() == 0) {
-                            bids.erase(order.price);
-                        }
-                    }
-                    else {
-                        std::cout << "Order doesn't exist in the order book" << std::endl;
-                    }
-                }
-                else {
-                    std::cout << "Order doesn't exist in the order book" << std::endl;
-                }
-            }
+    auto readStart = std::chrono::steady_clock::now();
 
-            else if (order.category == "TRADE") {
-                // Check if the order exists in the order book by checking the order price (key of the map)
-                // if it does, and there are enough quantity at that price, then update the quantity (subtract the traded quantity)
-                // and go through the samePriceOrders vector and subtract the traded quantity from the first element of the vector to the last accordingly
-                // if the quantity at that price in samePriceOrders vector reaches 0, then remove the price level from the order book.
-                // if the quantity at that price in samePriceOrders vector is less than 0, then throw an error
-
-                if (bids.find(order.price) != bids.end()) {
-                    // Check if there are enough quantity at that price
-                    if (bids[order.price].quantity >= order.quantity) {
-                        // Update the quantity
-                        bids[order.price].quantity -= order.quantity;
-
-                        int removeQuantity = order.quantity;
-
-                        for (auto it = bids[order.price].samePriceOrders.begin(); it != bids[order.price].samePriceOrders.end();) {
-                            if (it->quantity >= removeQuantity) {
-                                it->quantity -= removeQuantity;
-                                // Remove the order from the order book if the quantity reaches 0 <=> the order has been traded/processed
-                                if (it->quantity == 0) {
-                                    bids[order.price].samePriceOrders.erase(it);
-                                }
-                                if (bids[order.price].samePriceOrders.size() == 0) {
-                                    bids.erase(order.price);
-                                }
-                                break; // found enough quantity of orders to subtract from (ie: to trade)
-                            }
-                            else {
-                                removeQuantity -= it->quantity; // Update the removeQuantity to subtract from the next element in the vector
-                                it = bids[order.price].samePriceOrders.erase(it); // Remove the element from the vector
-                                // if size of vector is 0, then remove the order at that price from the order book
-                                if (bids[order.price].samePriceOrders.size() == 0) {
-                                    bids.erase(order.price);
-                                }
-                            }
-                        }
-                    }
-                    else {
-                        std::cout << "Not enough quantity at that price" << std::endl;
-                    }
-                }
-                else {
-                    std::cout << "Order doesn't exist in the order book" << std::endl;
-                };
-            }
-        }
-        else if (order.side == "SELL") {
-            // NEW, CANCEL, TRADE (Modify) cases
-            if (order.category == "NEW") {
-                // Case #1: Order at that price doesn't exist in the order book (BID side)
-                if (asks.find(order.price) == asks.end()) {
-                    // Add the order price as key, and the quantity to the samePriceOrders vector too
-                    asks[order.price] = order;
-                    asks[order.price].samePriceOrders.push_back(order);
-                }
+    // If the log has checkpoints (Orderbook checkpoint <log> <symbol>), start from the last one before the time range instead of the first line
+    CheckpointIndexEntry checkpoint;
+    if (restoreLastCheckpoint(filePath, symbol, file.size(), snapshotStartTime, snapshotEndTime, orderbook, checkpoint)) {
+        file.seek(checkpoint.position);
+        anyOrderProcessed = checkpoint.ordersProcessed > 0;
+        lastTimestamp = checkpoint.lastOrderTimestamp;
+        std::cerr << "Restored checkpoint at " << checkpoint.timestamp << " (" << checkpoint.orderCount << " resting orders)" << std::endl;
+    }
+    size_t startOffset = file.offset();
 
-                // Case #2: Order at that price already exists in the order book, so add it to the samePriceOrders vector
-                else {
-                    // Update the quantity of the order too
-                    asks[order.price].quantity += order.quantity;
-                    asks[order.price].samePriceOrders.push_back(order);
-                }
+    if (pipelined) {
+        replayPipelined(file, symbols, symbolId, orderbook, snapshots, symbol, snapshotStartTime, snapshotEndTime, numberOfFields, anyOrderProcessed, lastTimestamp,
+                        snapshotGrid.enabled() ? &snapshotGrid : nullptr);
+    }
+    else {
+        // Timestamp of the last line read, of any symbol: the sampled snapshots are taken up to it
+        int64_t lastLineTimestamp = INT64_MIN;
+        while (file.nextLine(line)) {
+            Order order;
+
+            if (!parseOrderLine(line, order, symbols)) {
+                std::cerr << "Error reading line!" << std::endl;
+                continue;
             }
+            lastLineTimestamp = order.timestamp;
 
-            else if (order.category == "CANCEL") {
-                // Cancel the order at that price by checking orderId with the samePriceOrders vector orderIds, if after cancelling the order (deleting it), the size of the vector is 0, then delete the order at that price from the order book
-                // If the order doesn't exist in the order book, then throw an error
-                if (asks.find(order.price) != asks.end()) {
-                    // Check if the orderId exists in the samePriceOrders vector
-                    auto it = std::find_if(asks[order.price].samePriceOrders.begin(), asks[order.price].samePriceOrders.end(), [&order](const Order& o) {return o.orderId == order.orderId; });
-                    if (it != asks[order.price].samePriceOrders.end()) {
-
-                        // Update the price by substracting the quantity of the order that will be deleted from the quantity of the order at that price
-                        asks[order.price].quantity -= it->quantity;
-                        // Remove the order from the samePriceOrders vector
-                        asks[order.price].samePriceOrders.erase(it);
-                        // Check if the size of the samePriceOrders vector is 0, if it is, then remove the order at that price from the order book
-                        if (asks[order.price].samePriceOrders.size() == 0) {
-                            asks.erase(order.price);
-                        }
-                    }
-                    else {
-                        std::cout << "Order doesn't exist in the order book" << std::endl;
-                    }
-                }
-                else {
-                    std::cout << "Order doesn't exist in the order book" << std::endl;
-                }
-            }
-            else if (order.category == "TRADE") {
-                // Check if the order exists in the order book by checking the order price (key of the map)
-                // if it does, and there are enough quantity at that price, then update the quantity (subtract the traded quantity)
-                // and go through the samePriceOrders vector and subtract the traded quantity from the first element of the vector to the last accordingly
-                // if the quantity at that price in samePriceOrders vector reaches 0, then remove the price level from the order book.
-                // if the quantity at that price in samePriceOrders vector is less than 0, then throw an error
-                if (asks.find(order.price) != asks.end()) {
-                    // Check if there are enough quantity at that price
-                    if (asks[order.price].quantity >= order.quantity) {
-                        // Update the quantity
-                        asks[order.price].quantity -= order.quantity;
-
-                        int removeQuantity = order.quantity;
-
-                        for (auto it = asks[order.price].samePriceOrders.begin(); it != asks[order.price].samePriceOrders.end();) {
-                            if (it->quantity >= removeQuantity) {
-                                it->quantity -= removeQuantity;
-                                // Remove the order from the order book if the quantity reaches 0 <=> the order has been traded/processed
-                                if (it->quantity == 0) {
-                                    asks[order.price].samePriceOrders.erase(it);
-                                }
-                                // if size of vector is 0, then remove the order at that price from the order book
-                                if (asks[order.price].samePriceOrders.size() == 0) {
-                                    asks.erase(order.price);
-                                }
-                                break; // found enough quantity of orders to subtract from (ie: to trade)
-                            }
-                            else {
-                                removeQuantity -= it->quantity; // Update the removeQuantity to subtract from the next element in the vector
-                                it = asks[order.price].samePriceOrders.erase(it); // Remove the element from the vector
-                                // if size of vector is 0, then remove the order at that price from the order book
-                                if (asks[order.price].samePriceOrders.size() == 0) {
-                                    asks.erase(order.price);
-                                }
-                            }
-                        }
-                    }
-                    else {
-                        std::cout << "Not enough quantity at that price" << std::endl;
-                    }
-                }
-                else {
-                    std::cout << "Order doesn't exist in the order book" << std::endl;
-                };
+            // The log is sorted by timestamp, nothing after the end time can change the snapshots
+            if (order.timestamp > snapshotEndTime) {
+                break;
             }
 
+            // check the timestamp of the order,if it's smaller than end time, then process the order.
+            // Inside the process order, it will check the start time too , and if it's between start and end time, then it will write a snapshot
+            if (order.symbol == symbolId) {
+				orderbook.processOrder(order, symbol, snapshotStartTime, snapshotEndTime, numberOfFields);
+				anyOrderProcessed = true;
+				lastTimestamp = order.timestamp;
+			}
+
+            //orders.push_back(order);
         }
+        orderbook.takeSampledSnapshots(lastLineTimestamp, symbol, numberOfFields);
+    }
+
+    // Report how fast the log was read (parsing and processing of the orders)
+    std::chrono::duration<double> readTime = std::chrono::steady_clock::now() - readStart;
+    if (readTime.count() > 0) {
+        size_t bytesRead = file.offset() - startOffset;
+        std::cerr << "Read " << file.lineCount() << " lines (" << bytesRead << " bytes) in " << readTime.count() << " s: "
+            << static_cast<uint64_t>(file.lineCount() / readTime.count()) << " lines/s, "
+            << bytesRead / readTime.count() / 1e9 << " GB/s" << std::endl;
+    }
+
+    for (const auto& order : orders) {
+        std::cout << "Epoch: " << order.timestamp << ", Order ID: " << order.orderId << ", Symbol: " << symbols.name(order.symbol)
+            << ", Side: " << sideToString(order.side) << ", Category: " << categoryToString(order.category) << ", Price: " << ticksToPrice(order.price)
+            << ", Quantity: " << order.quantity << std::endl;
+    }
 
-        // Add snapshot of the order book to a vector of snapshots
-        // Check if snapshot is between startTime and endTime
-        if (order.timestamp >= snapshotStartTime && order.timestamp <= snapshotEndTime) {
-            // Create a snapshot of the current timestamp, and symbol
-            Snapshot newSnapshot;
-            newSnapshot.timestamp = order.timestamp;
-            newSnapshot.symbol = symbol;
+    outputOrderBook(orderbook, snapshots, symbol, snapshotStartTime, anyOrderProcessed, lastTimestamp, numberOfFields);
+}
 
-            // Get top n bids and asks if they exist (ie: get the first N elements of the bids and asks if they exist)
-            getTopBids(newSnapshot, numberOfFields);
-            getTopAsks(newSnapshot, numberOfFields);
+// Same as ReadTextFile but for a binary log written by convertLogToBinary (see EventLog.h)
+// The file is memory mapped and the orders are given to the order book straight from the mapping
+template <typename Book>
+void ReadBinaryFile(const std::string& filePath, const std::string& symbol, int64_t snapshotStartTime=0, int64_t snapshotEndTime=0, SnapshotFormat snapshotFormat=SnapshotFormat::Text,
+                    bool analyticsColumns=false, int64_t sampleInterval=0)
+{
+    Book orderbook;
+    int numberOfFields = SNAPSHOT_DEPTH;
+    BinaryLogReader log;
+    if (!log.open(filePath)) {
+        return;
+    }
 
-            // Add the snapshot to the vector of snapshots
-            snapshots.push_back(newSnapshot);
+    SnapshotWriter snapshots(snapshotFileName(snapshotFormat), symbol, snapshotFormat, SnapshotWriter::DEFAULT_BUFFER_SIZE, analyticsColumns);
+    SnapshotGrid snapshotGrid(snapshotStartTime, snapshotEndTime, snapshotStartTime != 0 ? sampleInterval : 0);
+    if (snapshotStartTime != 0) {
+        orderbook.setSnapshotWriter(&snapshots);
+        if (snapshotGrid.enabled()) {
+            orderbook.setSnapshotGrid(&snapshotGrid);
         }
     }
+    bool anyOrderProcessed = false;
+    int64_t lastTimestamp = 0;
+
+    uint16_t symbolId = log.symbolTable().find(symbol);
+
+    // Same as ReadTextFile: start from the last checkpoint before the time range if there is one
+    const Order* first = log.begin();
+    CheckpointIndexEntry checkpoint;
+    if (restoreLastCheckpoint(filePath, symbol, log.size(), snapshotStartTime, snapshotEndTime, orderbook, checkpoint)) {
+        first += checkpoint.position;
+        anyOrderProcessed = checkpoint.ordersProcessed > 0;
+        lastTimestamp = checkpoint.lastOrderTimestamp;
+        std::cerr << "Restored checkpoint at " << checkpoint.timestamp << " (" << checkpoint.orderCount << " resting orders)" << std::endl;
+    }
 
-    void printOrderBook() {
-        // Print the order book of each side, and their samePriceOrders vectors
-        std::cout << "BID SIDE" << std::endl;
-        for (auto& bid : bids) {
-            std::cout << "Price: " << bid.first << ", Quantity: " << bid.second.quantity;
-            std::cout << ", Orders: ";
-            std::cout << "[";
-            for (auto& samePriceOrder : bid.second.samePriceOrders) {
-                std::cout << samePriceOrder.quantity << " (" << "id:" << samePriceOrder.orderId << "), ";
-            }
-            std::cout << " ]";
-            std::cout << std::endl;
+    int64_t lastRecordTimestamp = INT64_MIN;
+    for (const Order* order = first; order != log.end(); ++order) {
+        // Same as ReadTextFile: only the orders of that symbol up to the end time are processed, the snapshots are taken between start and end time
+        lastRecordTimestamp = order->timestamp;
+        if (order->timestamp > snapshotEndTime) {
+            break;
+        }
+        if (order->symbol == symbolId) {
+            orderbook.processOrder(*order, symbol, snapshotStartTime, snapshotEndTime, numberOfFields);
+            anyOrderProcessed = true;
+            lastTimestamp = order->timestamp;
         }
+    }
+    orderbook.takeSampledSnapshots(lastRecordTimestamp, symbol, numberOfFields);
+
+    outputOrderBook(orderbook, snapshots, symbol, snapshotStartTime, anyOrderProcessed, lastTimestamp, numberOfFields);
+}
 
-        std::cout << "\n";
+// Process every symbol of the log, each one in its own order book, using a pool of worker threads (see BookManager.h)
+// The snapshots of each symbol are written to snapshots_<symbol>.txt (or .bin) as they are taken
+template <typename Book>
+void ReadFileAllSymbols(const std::string& filePath, int64_t snapshotStartTime, int64_t snapshotEndTime, size_t workerCount, SnapshotFormat snapshotFormat=SnapshotFormat::Text)
+{
+    BookManager<Book> manager(workerCount, snapshotStartTime, snapshotEndTime, SNAPSHOT_DEPTH, "snapshots_", snapshotFormat);
 
-        std::cout << "ASK SIDE" << std::endl;
-        for (auto& ask : asks) {
-            std::cout << "Price: " << ask.first << ", Quantity: " << ask.second.quantity;
-            std::cout << ", Orders: ";
-            std::cout << "[";
-            for (auto& samePriceOrder : ask.second.samePriceOrders) {
-                std::cout << samePriceOrder.quantity << " (" << "id:" << samePriceOrder.orderId << "), ";
+    if (isBinaryLog(filePath)) {
+        BinaryLogReader log;
+        if (!log.open(filePath)) {
+            return;
+        }
+        for (const Order& order : log) {
+            if (order.timestamp > snapshotEndTime) {
+                break; // sorted by timestamp, see ReadTextFile
             }
-            std::cout << " ]";
-            std::cout << std::endl;
+            manager.submit(order, log.symbolTable());
         }
     }
-
-    void printSnapshots() {
-        // Print the snapshots
-        for (auto& snapshot : snapshots) {
-            std::cout << snapshot.symbol << ", " << snapshot.timestamp << ", ";
-            for (auto& bid : snapshot.bidSnapshots) {
-                std::cout << bid << " ";
+    else {
+        TextLogReader file;
+        if (!file.open(filePath)) {
+            std::cerr << "Unable to open file!" << std::endl;
+            return;
+        }
+        SymbolTable symbols;
+        std::string_view line;
+        while (file.nextLine(line)) {
+            Order order;
+            if (!parseOrderLine(line, order, symbols)) {
+                std::cerr << "Error reading line!" << std::endl;
+                continue;
             }
-            std::cout << "X ";
-            
-            for (auto& ask : snapshot.askSnapshots) {
-                std::cout << ask << " ";
+            if (order.timestamp > snapshotEndTime) {
+                break;
             }
-            std::cout << std::endl;
+            manager.submit(order, symbols);
         }
     }
 
-    // Get the top n bids from the order book. Used for snapshots
-    void getTopBids(Snapshot& snapshot, int numberOfFields) {
-        // Get the top n bids from the bids map (first n elements of the map if they exist, otherwise the minimum number of elements that exist)
-        int numElements = std::min(static_cast<int>(bids.size()), numberOfFields);
-
-        // Get the first n elements of the map and add them to the snapshot
-        for (auto it = bids.begin(); it != bids.end(); ++it) {
-            std::ostringstream oss;
-            oss <<  std::setprecision(5) << it->first;
-            std::string priceString = oss.str();
-            // Add the snapshot to the vector of bid snapshots
-			snapshot.bidSnapshots.push_back(std::to_string(it->second.quantity) + "@" + priceString);
-            // break if we reach numElements
-            if (--numElements == 0) {
-				break;
-			}
-		}
-        std::reverse(snapshot.bidSnapshots.begin(), snapshot.bidSnapshots.end());
-    }
-
-    // Get the top n asks from the order book. Used for snapshots
-    void getTopAsks(Snapshot& snapshot, int numberOfFields) {
-        // Get the top n bids from the bids map (first n elements of the map if they exist, otherwise the minimum number of elements that exist)
-        int numElements = std::min(static_cast<int>(asks.size()), numberOfFields);
-
-        // Get the first n elements of the map and add them to the snapshot
-        for (auto it = asks.begin(); it != asks.end(); ++it) {
-            std::ostringstream oss;
-            oss << std::setprecision(5) << it->first;
-            std::string priceString = oss.str();
-            // Add the snapshot to the vector of ask snapshots
-            snapshot.askSnapshots.push_back(std::to_string(it->second.quantity) + "@" + priceString);
-            // break if we reach numElements
-            if (--numElements == 0) {
+    manager.finish();
+
+    BookMetrics totalMetrics;
+    manager.forEachBook([&](typename BookManager<Book>::SymbolBook& symbolBook) {
+        std::cout << symbolBook.symbol << ": " << symbolBook.ordersProcessed << " orders, " << symbolBook.book.getMetrics().totalRejects() << " rejected, "
+            << symbolBook.snapshots->recordCount() << " snapshots -> " << manager.snapshotFileName(symbolBook.symbol) << std::endl;
+        totalMetrics.merge(symbolBook.book.getMetrics());
+    });
+    std::cout << "\nAll symbols\n";
+    totalMetrics.print(std::cout);
+}
+
+// Follow a live feed (a growing log, stdin or a UNIX socket, see LiveFeed.h) and write a snapshot after every order of the symbol
+// between start and end time (every order with a start time of 0) as the lines arrive.
+// The snapshots are flushed to the file every time all the lines read so far are processed, so a snapshot reaches the file at most
+// one read (64 KB of log) after its line arrived. The delay from reading a line to its snapshot being in the file is measured for each snapshot.
+// Stops at the end of the stream, after the end time, after idleMilliseconds without new lines (0: never) or on Ctrl-C.
+template <typename Book>
+void ReadLive(const std::string& source, const std::string& symbol, int64_t snapshotStartTime, int64_t snapshotEndTime, int64_t idleMilliseconds,
+              SnapshotFormat snapshotFormat=SnapshotFormat::Text)
+{
+    LiveLogSource feed;
+    if (!feed.open(source)) {
+        return;
+    }
+    std::signal(SIGINT, requestLiveStop);
+
+    Book orderbook;
+    SnapshotWriter snapshots(snapshotFileName(snapshotFormat), symbol, snapshotFormat);
+    orderbook.setSnapshotWriter(&snapshots);
+    SymbolTable symbols;
+    uint16_t symbolId = symbols.intern(symbol);
+    int numberOfFields = SNAPSHOT_DEPTH;
+
+    LatencyHistogram ingestToSnapshot; // in ns
+    std::vector<int64_t> pendingIngestTimes; // ingest time of the lines of the snapshots written since the last flush
+    int64_t lastDataTime = steadyNanoseconds();
+    bool streamEnded = false;
+    bool pastEndTime = false;
+    std::string_view line;
+    int64_t ingestTime;
+    while (true) {
+        while (!pastEndTime && feed.nextLine(line, ingestTime)) {
+            Order order;
+            if (!parseOrderLine(line, order, symbols)) {
+                std::cerr << "Error reading line!" << std::endl;
+                continue;
+            }
+            // Same as ReadTextFile, the feed is sorted by timestamp
+            if (order.timestamp > snapshotEndTime) {
+                pastEndTime = true;
                 break;
             }
+            if (order.symbol == symbolId) {
+                uint64_t snapshotsBefore = snapshots.recordCount();
+                orderbook.processOrder(order, symbol, snapshotStartTime, snapshotEndTime, numberOfFields);
+                if (snapshots.recordCount() != snapshotsBefore) {
+                    pendingIngestTimes.push_back(ingestTime);
+                }
+            }
         }
-    }
 
-    void saveSnapshotsTimeToFile(bool singleSnapshot) {
-        // Save the snapshots to a file
-        std::ofstream snapshotsFile("snapshots.txt");
-        if (!snapshotsFile.is_open()) {
-            std::cerr << "Unable to open file for writing!" << std::endl;
-            return;
+        // Every line read so far is processed, push the snapshots to the file before waiting for more
+        if (!pendingIngestTimes.empty()) {
+            snapshots.flush();
+            int64_t flushTime = steadyNanoseconds();
+            for (int64_t lineIngestTime : pendingIngestTimes) {
+                ingestToSnapshot.record(static_cast<uint64_t>(flushTime - lineIngestTime));
+            }
+            pendingIngestTimes.clear();
         }
 
-            // If we only want to output the last snapshot at snapshotEndTime (only one time is given which is the end time)
-        if (singleSnapshot) {
-			// Get the last snapshot
-			Snapshot snapshot = snapshots.back();
-			snapshotsFile << snapshot.symbol << ", " << snapshot.timestamp << ", ";
-			for (auto& bid : snapshot.bidSnapshots) {
-				snapshotsFile << bid << " ";
-			}
-			snapshotsFile << "X ";
-
-			for (auto& ask : snapshot.askSnapshots) {
-				snapshotsFile << ask << "  ";
-			}
-			snapshotsFile << std::endl;
-		}
-		else { // if we want to output a range of snapshots from snapshotStartTime to snapshotEndTime
-			for (const auto& snapshot : snapshots) {
-				snapshotsFile << snapshot.symbol << ", " << snapshot.timestamp << ", ";
-				for (auto& bid : snapshot.bidSnapshots) {
-					snapshotsFile << bid << " ";
-				}
-				snapshotsFile << "X ";
-
-				for (auto& ask : snapshot.askSnapshots) {
-					snapshotsFile << ask << "  ";
-				}
-				snapshotsFile << std::endl;
-			}
-		}
-
-        snapshotsFile.close();
+        if (streamEnded || pastEndTime || liveStopRequested) {
+            break;
+        }
+        LiveLogSource::Status status = feed.fill();
+        if (status == LiveLogSource::Status::Data) {
+            lastDataTime = steadyNanoseconds();
+        }
+        else if (status == LiveLogSource::Status::End) {
+            streamEnded = true; // one more pass for a last line without an end of line
+        }
+        else if (idleMilliseconds > 0 && steadyNanoseconds() - lastDataTime > idleMilliseconds * 1000000) {
+            break;
+        }
     }
-};
 
+    orderbook.printOrderBook();
+    std::cout << "\n\n";
+    snapshots.flush();
+    std::cout << feed.lineCount() << " lines read, " << snapshots.recordCount() << " snapshots written" << std::endl;
+    std::cout << "\n";
+    orderbook.getMetrics().print(std::cout);
+    std::cout << "Ingest to snapshot ns: p50 " << ingestToSnapshot.percentile(0.5) << ", p99 " << ingestToSnapshot.percentile(0.99) << ", p99.9 "
+        << ingestToSnapshot.percentile(0.999) << ", max " << ingestToSnapshot.max() << " (" << ingestToSnapshot.count() << " snapshots)" << std::endl;
+}
 
-void ReadFile(const std::string& filePath, const std::string& symbol, int64_t snapshotStartTime=0, int64_t snapshotEndTime=0)
+// Batch mode: run every job of a manifest (see BatchReplay.h) on a pool of workers, one order book per job and one snapshot file per job
+template <typename Book>
+void ReplayBatch(const std::string& manifestPath, size_t workerCount)
 {
-    OrderBook orderbook;
-    int numberOfFields = 5; // can be modified to get more or less fields for the snapshots
-    std::ifstream file(filePath);
-    if (!file.is_open()) {
-        std::cerr << "Unable to open file!" << std::endl;
-        //return 1;
+    std::vector<ReplayJob> jobs;
+    if (!readReplayManifest(manifestPath, jobs)) {
+        return;
     }
-
-    std::vector<Order> orders;
-    std::string line;
-
-    //int linesRead = 0; // testing purposes
-
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        Order order;
-
-        if (!(iss >> order.timestamp >> order.orderId >> order.symbol >> order.side >> order.category >> order.price >> order.quantity)) {
-            std::cerr << "Error reading line!" << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    size_t stealCount = 0;
+    std::vector<ReplayJobResult> results = runReplayBatch<Book>(jobs, workerCount, &stealCount);
+    std::chrono::duration<double> wallTime = std::chrono::steady_clock::now() - start;
+
+    double largestJob = 0;
+    double totalJobs = 0;
+    size_t failedJobs = 0;
+    for (const ReplayJobResult& result : results) {
+        const ReplayJob& job = result.job;
+        std::cout << job.logPath << " " << job.symbol << " [" << job.startTime << ", " << job.endTime << "]: ";
+        if (!result.succeeded) {
+            std::cout << "failed" << std::endl;
+            failedJobs++;
             continue;
         }
-
-        // check the timestamp of the order,if it's smaller than end time, then process the order.
-        // Inside the process order, it will check the start time too , and if it's between start and end time, then it will add it to the snapshots vector
-        if (order.timestamp <= snapshotEndTime) {
-			orderbook.processOrder(order, symbol, snapshotStartTime, snapshotEndTime);
-		}
-
-        //orders.push_back(order);
-
-        //linesRead++;
+        std::cout << result.ordersProcessed << " orders, " << result.rejects << " rejected, " << result.snapshotsWritten << " snapshots -> "
+            << job.output << " (" << result.seconds << " s)" << std::endl;
+        largestJob = std::max(largestJob, result.seconds);
+        totalJobs += result.seconds;
     }
+    std::cout << "\n" << results.size() << " jobs (" << failedJobs << " failed) on " << std::max<size_t>(workerCount, 1) << " workers in " << wallTime.count()
+        << " s, largest job " << largestJob << " s, sum of the jobs " << totalJobs << " s, " << stealCount << " jobs stolen" << std::endl;
+}
 
-    file.close();
+// Matching mode: replay a log (text or binary) of an order flow for one symbol, crossing the NEW orders that reach the opposite side
+// instead of resting them (see BasicOrderBook::setFillBuffer). The fills are written to fillsFilePath, one per line:
+// timestamp takerOrderId makerOrderId takerSide price quantity
+template <typename Book>
+void MatchFile(const std::string& filePath, const std::string& symbol, const std::string& fillsFilePath)
+{
+    std::ofstream fillsFile(fillsFilePath);
+    if (!fillsFile.is_open()) {
+        std::cerr << "Unable to open file for writing!" << std::endl;
+        return;
+    }
+    Book orderbook;
+    FillBuffer fills;
+    orderbook.setFillBuffer(&fills);
+    auto processOrder = [&](const Order& order) {
+        orderbook.processOrder(order, symbol);
+        for (const Fill& fill : fills) {
+            fillsFile << fill.timestamp << ' ' << fill.takerOrderId << ' ' << fill.makerOrderId << ' ' << sideToString(fill.takerSide) << ' '
+                << ticksToPrice(fill.price) << ' ' << fill.quantity << '\n';
+        }
+        fills.clear();
+    };
 
-    for (const auto& order : orders) {
-        std::cout << "Epoch: " << order.timestamp << ", Order ID: " << order.orderId << ", Symbol: " << order.symbol
-            << ", Side: " << order.side << ", Category: " << order.category << ", Price: " << order.price
-            << ", Quantity: " << order.quantity << std::endl;
+    if (isBinaryLog(filePath)) {
+        BinaryLogReader log;
+        if (!log.open(filePath)) {
+            return;
+        }
+        uint16_t symbolId = log.symbolTable().find(symbol);
+        for (const Order& order : log) {
+            if (order.symbol == symbolId) {
+                processOrder(order);
+            }
+        }
+    }
+    else {
+        TextLogReader file;
+        if (!file.open(filePath)) {
+            std::cerr << "Unable to open file!" << std::endl;
+            return;
+        }
+        SymbolTable symbols;
+        uint16_t symbolId = symbols.intern(symbol);
+        std::string_view line;
+        while (file.nextLine(line)) {
+            Order order;
+            if (!parseOrderLine(line, order, symbols)) {
+                std::cerr << "Error reading line!" << std::endl;
+                continue;
+            }
+            if (order.symbol == symbolId) {
+                processOrder(order);
+            }
+        }
     }
 
     orderbook.printOrderBook();
     std::cout << "\n\n";
-    orderbook.printSnapshots();
-    if (snapshotStartTime == 0) { // if we want to output the last snapshot at snapshotEndTime (only one time is given which is the end time)
-        orderbook.saveSnapshotsTimeToFile(true); 
+    std::cout << fills.totalFills() << " fills written to " << fillsFilePath << std::endl;
+    std::cout << "\n";
+    orderbook.getMetrics().print(std::cout);
+}
+
+// Rebuild the full text snapshots (same lines as SnapshotFormat::Text, without the duplicates) from a delta snapshot file
+// Returns the number of snapshots written
+uint64_t DecodeSnapshots(const std::string& deltaFilePath, const std::string& textFilePath) {
+    MappedFile file;
+    SnapshotFileHeader header;
+    if (!file.open(deltaFilePath) || file.size() < sizeof(header)) {
+        std::cerr << "Unable to open " << deltaFilePath << std::endl;
+        return 0;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, SNAPSHOT_DELTA_MAGIC, sizeof(header.magic)) != 0 || header.ticksPerUnit != TICKS_PER_UNIT) {
+        std::cerr << deltaFilePath << " isn't a delta snapshot file of this version" << std::endl;
+        return 0;
     }
-    else { // if we want to output a range of snapshots from snapshotStartTime to snapshotEndTime
-        orderbook.saveSnapshotsTimeToFile(false);
+    header.symbol[sizeof(header.symbol) - 1] = '\0';
+    std::string symbol = header.symbol;
+
+    SnapshotWriter snapshots(textFilePath, symbol, SnapshotFormat::Text);
+    SnapshotDeltaDecoder decoder;
+    const char* record = file.data() + sizeof(header);
+    const char* end = file.data() + file.size();
+    while (record < end) {
+        record = decoder.decode(record, end);
+        if (record == nullptr) {
+            std::cerr << deltaFilePath << " is truncated or corrupted, stopped after " << snapshots.recordCount() << " snapshots" << std::endl;
+            break;
+        }
+        snapshots.write(decoder.getTimestamp(), symbol, decoder.getBids(), decoder.getAsks());
     }
+    snapshots.flush();
+    return snapshots.recordCount();
 }
 
-// function to save orders to a binary file (for faster reading)
-
-void saveOrdersToBinary(const std::string& txtFilename, const std::string& binFilename) {
-    std::ifstream file(txtFilename);
-    if (!file.is_open()) {
-        std::cerr << "Unable to open file!" << std::endl;
-        return;
+void getSnapshotInTimeRange(const std::string& filePath, const std::string& symbol, int64_t startSnapshotTime=0, int64_t endSnapshotTime=0, BookType bookType=BookType::Map,
+                            SnapshotFormat snapshotFormat=SnapshotFormat::Text, bool pipelined=false, bool analyticsColumns=false, int64_t sampleInterval=0) {
+	// Read the file and process the orders, the snapshots are written to the snapshots file as they are taken
+    // Then we'll print the order book
+    bool binary = isBinaryLog(filePath);
+    if (bookType == BookType::Ladder) {
+        if (binary) ReadBinaryFile<LadderOrderBook>(filePath, symbol, startSnapshotTime, endSnapshotTime, snapshotFormat, analyticsColumns, sampleInterval);
+        else ReadTextFile<LadderOrderBook>(filePath, symbol, startSnapshotTime, endSnapshotTime, snapshotFormat, pipelined, analyticsColumns, sampleInterval);
+    }
+    else if (bookType == BookType::Flat) {
+        if (binary) ReadBinaryFile<FlatOrderBook>(filePath, symbol, startSnapshotTime, endSnapshotTime, snapshotFormat, analyticsColumns, sampleInterval);
+        else ReadTextFile<FlatOrderBook>(filePath, symbol, startSnapshotTime, endSnapshotTime, snapshotFormat, pipelined, analyticsColumns, sampleInterval);
     }
+    else {
+        if (binary) ReadBinaryFile<OrderBook>(filePath, symbol, startSnapshotTime, endSnapshotTime, snapshotFormat, analyticsColumns, sampleInterval);
+        else ReadTextFile<OrderBook>(filePath, symbol, startSnapshotTime, endSnapshotTime, snapshotFormat, pipelined, analyticsColumns, sampleInterval);
+    }
+}
 
 
-    std::ofstream binaryFile(binFilename, std::ios::binary);
-    if (!binaryFile.is_open()) {
-        std::cerr << "Unable to open binary file for writing!" << std::endl;
-        return;
+int main(int argc, char* argv[]) {
+    // Orderbook convert <log> <bin>: convert a text log to the binary format once, the .bin file can then be replayed instead of the .log
+    if (argc == 4 && std::string(argv[1]) == "convert") {
+        uint64_t ordersWritten = convertLogToBinary(argv[2], argv[3]);
+        std::cout << ordersWritten << " orders written to " << argv[3] << std::endl;
+        return 0;
     }
 
-    std::string line;
-    int ordersRead = 0; // testing purposes
-    int limitRead = 10; // testing purposes
-    while (std::getline(file, line) && ordersRead < limitRead) {
-        std::istringstream iss(line);
-        Order order;
+    // Orderbook checkpoint <log> <symbol> [interval]: write checkpoints of the book of that symbol every interval lines (<log>.<symbol>.ckpt),
+    // the time range queries on that log then start from the last checkpoint before their start time
+    if ((argc == 4 || argc == 5) && std::string(argv[1]) == "checkpoint") {
+        uint64_t interval = argc == 5 ? std::stoull(argv[4]) : DEFAULT_CHECKPOINT_INTERVAL;
+        std::string checkpointPath = checkpointFileName(argv[2], argv[3]);
+        uint64_t checkpointsWritten = writeCheckpoints<LadderOrderBook>(argv[2], argv[3], checkpointPath, interval);
+        std::cout << checkpointsWritten << " checkpoints written to " << checkpointPath << std::endl;
+        return 0;
+    }
 
-        if (!(iss >> order.timestamp >> order.orderId >> order.symbol >> order.side >> order.category >> order.price >> order.quantity)) {
-            std::cerr << "Error reading line!" << std::endl;
-            continue;
+    // Orderbook save <log> <symbol> <timestamp> [image]: save the whole book of that symbol after every line up to the timestamp
+    // (<log>.<symbol>.image by default), the time range queries on that log then start from it if it is before their start time
+    if ((argc == 5 || argc == 6) && std::string(argv[1]) == "save") {
+        std::string imagePath = argc == 6 ? argv[5] : bookImageFileName(argv[2], argv[3]);
+        if (saveBookImage<LadderOrderBook>(argv[2], argv[3], std::stoll(argv[4]), imagePath)) {
+            BookImageReader image;
+            if (image.open(imagePath)) {
+                const BookImageHeader& header = image.getHeader();
+                std::cout << "Book saved to " << imagePath << ": " << header.bidLevelCount << " bid levels, " << header.askLevelCount << " ask levels, "
+                    << header.orderCount << " resting orders" << std::endl;
+            }
         }
-
-        binaryFile.write(reinterpret_cast<const char*>(&order), sizeof(Order));
-        ordersRead++;
+        return 0;
     }
 
-    file.close();
-    binaryFile.close();
-}
-
-// function to read orders from a binary file (for faster reading) and print them
-// not working properly
-void readOrdersFromBinary(const std::string& binFilename) { 
-   std::ifstream binaryFile(binFilename, std::ios::binary);
-    if (!binaryFile.is_open()) {
-        std::cerr << "Unable to open binary file for reading!" << std::endl;
-        return;
+    // Orderbook all-symbols <log> <startTime> <endTime> [workers] [map|ladder|flat]: one order book per symbol of the log, processed by a
+    // pool of threads (ladder books by default, flat books take the least memory when the log has thousands of symbols)
+    if ((argc >= 5 && argc <= 7) && std::string(argv[1]) == "all-symbols") {
+        size_t workerCount = argc >= 6 ? std::stoul(argv[5]) : std::max(1u, std::thread::hardware_concurrency());
+        BookType bookType = BookType::Ladder;
+        if (argc == 7 && !parseBookType(argv[6], bookType)) {
+            std::cerr << "Unknown book type " << argv[6] << " (map, ladder or flat)" << std::endl;
+            return 1;
+        }
+        if (bookType == BookType::Flat) ReadFileAllSymbols<FlatOrderBook>(argv[2], std::stoll(argv[3]), std::stoll(argv[4]), workerCount);
+        else if (bookType == BookType::Map) ReadFileAllSymbols<OrderBook>(argv[2], std::stoll(argv[3]), std::stoll(argv[4]), workerCount);
+        else ReadFileAllSymbols<LadderOrderBook>(argv[2], std::stoll(argv[3]), std::stoll(argv[4]), workerCount);
+        return 0;
     }
 
-    Order order;
-    while (binaryFile.read(reinterpret_cast<char*>(&order), sizeof(Order))) {
-        std::cout << "Epoch: " << order.timestamp << ", Order ID: " << order.orderId
-            << ", Symbol: " << order.symbol << ", Side: " << order.side
-            << ", Category: " << order.category << ", Price: " << order.price
-            << ", Quantity: " << order.quantity << std::endl;
+    // Orderbook batch <manifest> [workers] [map|ladder|flat]: run every (log, symbol, time window) job of the manifest in one process,
+    // each job in its own book and to its own snapshot file (see BatchReplay.h for the manifest)
+    if ((argc >= 3 && argc <= 5) && std::string(argv[1]) == "batch") {
+        size_t workerCount = argc >= 4 ? std::stoul(argv[3]) : std::max(1u, std::thread::hardware_concurrency());
+        BookType bookType = BookType::Ladder;
+        if (argc == 5 && !parseBookType(argv[4], bookType)) {
+            std::cerr << "Unknown book type " << argv[4] << " (map, ladder or flat)" << std::endl;
+            return 1;
+        }
+        if (bookType == BookType::Flat) ReplayBatch<FlatOrderBook>(argv[2], workerCount);
+        else if (bookType == BookType::Map) ReplayBatch<OrderBook>(argv[2], workerCount);
+        else ReplayBatch<LadderOrderBook>(argv[2], workerCount);
+        return 0;
     }
 
-    binaryFile.close();
-}
+    // Orderbook match <log> <symbol> [fills file]: replay an order flow in matching mode, the NEW orders crossing the book trade with it (fills.txt by default)
+    if ((argc == 4 || argc == 5) && std::string(argv[1]) == "match") {
+        MatchFile<LadderOrderBook>(argv[2], argv[3], argc == 5 ? argv[4] : "fills.txt");
+        return 0;
+    }
 
-void getSnapshotInTimeRange(const std::string& filePath, const std::string& symbol, int64_t startSnapshotTime=0, int64_t endSnapshotTime=0) {
-	// Read the file and process the orders, then print and store the snapshots in file
-    // Then we'll print the snapshots vector
-    ReadFile(filePath, symbol, startSnapshotTime, endSnapshotTime);
-}
+    // Orderbook decode <snapshots.delta> [text file]: rebuild the full snapshots of a delta snapshot file (snapshots_decoded.txt by default)
+    if ((argc == 3 || argc == 4) && std::string(argv[1]) == "decode") {
+        std::string textFilePath = argc == 4 ? argv[3] : "snapshots_decoded.txt";
+        uint64_t snapshotsWritten = DecodeSnapshots(argv[2], textFilePath);
+        std::cout << snapshotsWritten << " snapshots written to " << textFilePath << std::endl;
+        return 0;
+    }
 
+    // Orderbook live <source> <symbol> [startTime endTime] [idle ms]: follow a log that is still being written (or "-" for stdin,
+    // "unix:<path>" for a UNIX socket) and write the snapshots as the orders arrive, see ReadLive
+    if ((argc == 4 || argc == 6 || argc == 7) && std::string(argv[1]) == "live") {
+        int64_t startTime = argc >= 6 ? std::stoll(argv[4]) : 0;
+        int64_t endTime = argc >= 6 ? std::stoll(argv[5]) : INT64_MAX;
+        int64_t idleMilliseconds = argc == 7 ? std::stoll(argv[6]) : 0;
+        ReadLive<LadderOrderBook>(argv[2], argv[3], startTime, endTime, idleMilliseconds);
+        return 0;
+    }
 
-int main() {
     OrderBook orderbook;
 
-    // file path, modify it to read the file
+    // file path, modify it to read the file (a .bin file written by "Orderbook convert" can be given instead of the .log)
     std::string filePathTxt = "SCH.log";
     std::string symbol = "SCS"; // symbol of the order book (SCS, SCH, etc.)
     //orderbook.printOrderBook();
@@ -513,10 +594,24 @@ int main() {
     int64_t startSnapshotTime = 1609723805976270988;
     int64_t endSnapshotTime = 1609723806144461785;
 
+    // Price levels container of the order book (BookType::Map, BookType::Ladder or BookType::Flat)
+    BookType bookType = BookType::Ladder;
+    // Layout of the snapshots file (SnapshotFormat::Text for snapshots.txt, SnapshotFormat::Binary for snapshots.bin
+    // or SnapshotFormat::Delta for snapshots.delta, only the changed levels, see "Orderbook decode")
+    SnapshotFormat snapshotFormat = SnapshotFormat::Text;
+    // Parse the text log, update the book and write the snapshots on three threads (same snapshots as the serial replay)
+    // Only when the three threads can run at the same time, on fewer hardware threads the handoffs make it slower than the serial replay
+    bool pipelined = std::thread::hardware_concurrency() >= 3;
+    // Add the mid, microprice, imbalance and VWAP of each side of the top N levels at the end of every snapshot
+    bool analyticsColumns = false;
+    // Sampling mode: a snapshot every sampleInterval ns from the start time (e.g. 100000 for 100 us, 1000000000 for 1 s), the book
+    // after the last order at or before each point, instead of a snapshot after every order (0)
+    int64_t sampleInterval = 0;
+
     // Get snapshot in time range
     // In the case of not giving a startSnapshotTime (ie: 0), then it will output the last snapshot at endSnapshotTime
     // because we only want the top N bids and asks at one specific time, instead of a range of time
-    getSnapshotInTimeRange(filePathTxt, symbol, startSnapshotTime, endSnapshotTime);
+    getSnapshotInTimeRange(filePathTxt, symbol, startSnapshotTime, endSnapshotTime, bookType, snapshotFormat, pipelined, analyticsColumns, sampleInterval);
 
     /*int64_t startSnapshotTime = 0;
     int64_t endSnapshotTime = 1609722900119980000;*/
@@ -525,17 +620,17 @@ int main() {
 
     // std::string binaryFilePath = "SCH.bin";
     // Save orders to binary file
-    // saveOrdersToBinary(filePathTxt, binaryFilePath);
-    // Read orders from binary file and process the data to update the order book
-    // readOrdersFromBinary(binaryFilePath);
+    // convertLogToBinary(filePathTxt, binaryFilePath);
+    // Read orders from binary file (memory mapped) and process the data to update the order book
+    // getSnapshotInTimeRange(binaryFilePath, symbol, startSnapshotTime, endSnapshotTime, bookType);
     
     //Code below is for testing purposes only:
    /* OrderBook orderBook;
 
-    Order order1 = { 1, 1, "SCH", "BUY", "NEW", 9.6, 4 };
-    Order order2 = { 2, 2, "SCH", "BUY", "NEW", 9.5, 6 };
-    Order order3 = { 4, 8, "SCH", "SELL", "NEW", 9.7, 5 };
-    Order order4 = { 6, 2, "SCH", "SELL", "NEW", 9.7, 10 };
+    Order order1 = { 1, 1, priceToTicks(9.6), 4, 0, Side::Buy, Category::New };
+    Order order2 = { 2, 2, priceToTicks(9.5), 6, 0, Side::Buy, Category::New };
+    Order order3 = { 4, 8, priceToTicks(9.7), 5, 0, Side::Sell, Category::New };
+    Order order4 = { 6, 2, priceToTicks(9.7), 10, 0, Side::Sell, Category::New };
     
 
   
@@ -544,20 +639,18 @@ int main() {
     orderBook.processOrder(order3, "SC", 1, 5);
     orderBook.processOrder(order4, "SC", 1, 5);
     
-    orderBook.printOrderBook();
-    std::cout << "\n\n";
-    orderBook.printSnapshots();*/
+    orderBook.printOrderBook();*/
 
 
     //std::cout << "\n\n\n\n";
     //// Trade an order
-    //Order order5 = { 6, 2, "SCH", "SELL", "CANCEL", 9.7, 4 };
+    //Order order5 = { 6, 2, priceToTicks(9.7), 4, 0, Side::Sell, Category::Cancel };
     //// 
-    ////Order order5 = { 6, 8, "SCH", "SELL", "TRADE", 9.7, 4 };
-    //Order order6 = { 7, 1, "SCH", "BUY", "TRADE", 9.6, 4 };
+    ////Order order5 = { 6, 8, priceToTicks(9.7), 4, 0, Side::Sell, Category::Trade };
+    //Order order6 = { 7, 1, priceToTicks(9.6), 4, 0, Side::Buy, Category::Trade };
    
-    ///* Order order7 = { 8, 5, "SCH", "SELL", "TRADE", 9.7, 10 };
-    //Order order8 = { 9, 5, "SCH", "SELL", "TRADE", 9.7, 25 };*/
+    ///* Order order7 = { 8, 5, priceToTicks(9.7), 10, 0, Side::Sell, Category::Trade };
+    //Order order8 = { 9, 5, priceToTicks(9.7), 25, 0, Side::Sell, Category::Trade };*/
 
     //orderBook.processOrder(order5);
     //orderBook.processOrder(order6);
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+#include "Order.h"
+#include "SymbolTable.h"
+#include "TextLog.h"
+#include "SnapshotWriter.h"
+#include "SnapshotGrid.h"
+
+// Staged replay of a text log: a parser thread turns the lines into orders, the calling thread applies them to the book
+// and a formatter thread turns the numeric top N views into the snapshot file. Parsing and formatting cost more than the
+// book updates, running them next to it leaves the book thread with the book updates and two copies of small arrays.
+//   parser --(batches of orders)--> book --(batches of snapshots)--> formatter
+// The stages are connected by bounded lock-free single producer single consumer rings of batches, the consumer gives the
+// emptied batches back through a second ring so the batches are reused instead of allocated.
+
+// Bounded lock-free queue between exactly one producer thread and one consumer thread
+// The producer only writes tail and the consumer only writes head, each keeps a copy of the other index and only reloads it
+// when the ring looks full (or empty), so the two threads rarely touch the same cache line.
+template <typename T>
+class SpscRing
+{
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    std::vector<T> slots;
+    size_t mask;
+
+    alignas(CACHE_LINE) std::atomic<size_t> head{ 0 }; // next slot to pop
+    size_t cachedTail = 0; // consumer copy of tail
+    alignas(CACHE_LINE) std::atomic<size_t> tail{ 0 }; // next slot to push
+    size_t cachedHead = 0; // producer copy of head
+    alignas(CACHE_LINE) std::atomic<bool> closed{ false };
+
+public:
+    // capacity is rounded up to a power of two
+    explicit SpscRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer: returns false if the ring is full (the item is left untouched)
+    bool tryPush(T& item) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        if (position - cachedHead == slots.size()) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (position - cachedHead == slots.size()) {
+                return false;
+            }
+        }
+        slots[position & mask] = std::move(item);
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: returns false if the ring is empty
+    bool tryPop(T& item) {
+        size_t position = head.load(std::memory_order_relaxed);
+        if (position == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (position == cachedTail) {
+                return false;
+            }
+        }
+        item = std::move(slots[position & mask]);
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer: wait until there is room
+    void push(T& item) {
+        while (!tryPush(item)) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Consumer: wait for the next item, returns false once the ring is closed and empty
+    bool pop(T& item) {
+        while (!tryPop(item)) {
+            if (closed.load(std::memory_order_acquire)) {
+                // Everything pushed before close is visible now
+                return tryPop(item);
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    // Producer: no more items will be pushed
+    void close() {
+        closed.store(true, std::memory_order_release);
+    }
+};
+
+// Link between two stages: full batches go forward, emptied batches come back to be filled again
+template <typename Batch>
+class BatchChannel
+{
+private:
+    SpscRing<Batch> filled;
+    SpscRing<Batch> recycled;
+
+public:
+    explicit BatchChannel(size_t capacity) : filled(capacity), recycled(capacity) {
+    }
+
+    // Producer: send the batch and get an empty one to fill in its place (a recycled one if the consumer gave one back)
+    void send(Batch& batch) {
+        filled.push(batch);
+        if (!recycled.tryPop(batch)) {
+            batch = Batch();
+        }
+        batch.clear();
+    }
+
+    // Producer: send what is left and tell the consumer there is nothing more
+    void close(Batch& batch) {
+        if (!batch.empty()) {
+            filled.push(batch);
+        }
+        filled.close();
+    }
+
+    // Consumer: wait for the next batch, returns false once every batch has been received
+    bool receive(Batch& batch) {
+        return filled.pop(batch);
+    }
+
+    // Consumer: hand a processed batch back to the producer (dropped if the producer already has enough of them)
+    void giveBack(Batch& batch) {
+        recycled.tryPush(batch);
+    }
+};
+
+// Orders going from the parser to the book
+struct OrderBatch {
+    std::vector<Order> orders;
+
+    bool empty() const {
+        return orders.empty();
+    }
+
+    void clear() {
+        orders.clear();
+    }
+};
+
+// Snapshots going from the book to the formatter, in numeric form: a timestamp and the top N levels of each side
+struct SnapshotBatch {
+    struct Record {
+        int64_t timestamp;
+        uint32_t bidCount;
+        uint32_t askCount;
+    };
+
+    std::vector<Record> records;
+    std::vector<DepthLevel> levels; // bids then asks of each record (best first), in the order of the records
+    std::vector<BookAnalytics> analytics; // one per record if the snapshots have the analytics columns, empty otherwise
+
+    void add(int64_t timestamp, const std::vector<DepthLevel>& bids, const std::vector<DepthLevel>& asks) {
+        records.push_back({ timestamp, static_cast<uint32_t>(bids.size()), static_cast<uint32_t>(asks.size()) });
+        levels.insert(levels.end(), bids.begin(), bids.end());
+        levels.insert(levels.end(), asks.begin(), asks.end());
+    }
+
+    void add(int64_t timestamp, const std::vector<DepthLevel>& bids, const std::vector<DepthLevel>& asks, const BookAnalytics& bookAnalytics) {
+        add(timestamp, bids, asks);
+        analytics.push_back(bookAnalytics);
+    }
+
+    bool empty() const {
+        return records.empty();
+    }
+
+    void clear() {
+        records.clear();
+        levels.clear();
+        analytics.clear();
+    }
+};
+
+constexpr size_t PIPELINE_ORDER_BATCH_SIZE = 1024;
+constexpr size_t PIPELINE_SNAPSHOT_BATCH_SIZE = 256;
+constexpr size_t PIPELINE_QUEUED_BATCHES = 32; // a stage waits when the next one is this far behind
+
+// Replay the rest of a text log for one symbol like ReadTextFile does, with the parsing and the snapshot formatting on their own threads.
+// The book is updated on the calling thread and the snapshots (one after every order of the symbol between the start and
+// end time, if the start time isn't 0) are written to `snapshots` in the same order and with the same bytes as the serial
+// replay. The parser stops at the first line after the end time.
+// With a snapshotGrid, the snapshots are taken at the points of the grid instead of after every order, like the serial replay does.
+template <typename Book>
+void replayPipelined(TextLogReader& file, SymbolTable& symbols, uint16_t symbolId, Book& orderbook, SnapshotWriter& snapshots, const std::string& symbol,
+                     int64_t snapshotStartTime, int64_t snapshotEndTime, int numberOfFields, bool& anyOrderProcessed, int64_t& lastTimestamp,
+                     SnapshotGrid* snapshotGrid = nullptr) {
+    BatchChannel<OrderBatch> orderChannel(PIPELINE_QUEUED_BATCHES);
+    BatchChannel<SnapshotBatch> snapshotChannel(PIPELINE_QUEUED_BATCHES);
+    int64_t lastLineTimestamp = INT64_MIN; // of any symbol, written by the parser and read once it is joined
+
+    std::thread parser([&] {
+        OrderBatch batch;
+        std::string_view line;
+        while (file.nextLine(line)) {
+            Order order;
+            if (!parseOrderLine(line, order, symbols)) {
+                std::cerr << "Error reading line!" << std::endl;
+                continue;
+            }
+            lastLineTimestamp = order.timestamp;
+            // The log is sorted by timestamp, nothing after the end time can change the snapshots
+            if (order.timestamp > snapshotEndTime) {
+                break;
+            }
+            // Only the orders of that symbol go to the book
+            if (order.symbol == symbolId) {
+                batch.orders.push_back(order);
+                if (batch.orders.size() == PIPELINE_ORDER_BATCH_SIZE) {
+                    orderChannel.send(batch);
+                }
+            }
+        }
+        orderChannel.close(batch);
+    });
+
+    std::thread formatter([&] {
+        SnapshotBatch batch;
+        while (snapshotChannel.receive(batch)) {
+            const DepthLevel* levels = batch.levels.data();
+            const BookAnalytics* analytics = batch.analytics.empty() ? nullptr : batch.analytics.data();
+            for (const SnapshotBatch::Record& record : batch.records) {
+                snapshots.write(record.timestamp, symbol, levels, record.bidCount, levels + record.bidCount, record.askCount, analytics);
+                levels += record.bidCount + record.askCount;
+                if (analytics != nullptr) {
+                    ++analytics;
+                }
+            }
+            snapshotChannel.giveBack(batch);
+        }
+    });
+
+    // Book stage: the book has no snapshot writer, the top N views are copied to the formatter instead (same condition as processOrder)
+    // The analytics are taken from the book here, they come from its running sums (see BookAnalytics.h)
+    bool analyticsColumns = snapshots.hasAnalyticsColumns();
+    OrderBatch orders;
+    SnapshotBatch snapshotBatch;
+    auto addSnapshot = [&](int64_t timestamp) {
+        if (analyticsColumns) {
+            snapshotBatch.add(timestamp, orderbook.getTopBids(numberOfFields), orderbook.getTopAsks(numberOfFields), orderbook.getAnalytics(numberOfFields));
+        }
+        else {
+            snapshotBatch.add(timestamp, orderbook.getTopBids(numberOfFields), orderbook.getTopAsks(numberOfFields));
+        }
+        if (snapshotBatch.records.size() == PIPELINE_SNAPSHOT_BATCH_SIZE) {
+            snapshotChannel.send(snapshotBatch);
+        }
+    };
+    while (orderChannel.receive(orders)) {
+        for (const Order& order : orders.orders) {
+            if (snapshotGrid != nullptr) {
+                // The grid points before this order see the book as it is now
+                snapshotGrid->takeUntil(order.timestamp - 1, addSnapshot);
+            }
+            orderbook.processOrder(order, symbol, snapshotStartTime, snapshotEndTime, numberOfFields);
+            if (snapshotGrid == nullptr && snapshotStartTime != 0 && order.timestamp >= snapshotStartTime && order.timestamp <= snapshotEndTime) {
+                addSnapshot(order.timestamp);
+            }
+        }
+        if (!orders.empty()) {
+            anyOrderProcessed = true;
+            lastTimestamp = orders.orders.back().timestamp;
+        }
+        orderChannel.giveBack(orders);
+    }
+    parser.join();
+    if (snapshotGrid != nullptr) {
+        // The book doesn't change after its last order, the grid points up to the last line read are taken on it
+        snapshotGrid->takeUntil(lastLineTimestamp, addSnapshot);
+    }
+    snapshotChannel.close(snapshotBatch);
+
+    formatter.join();
+}
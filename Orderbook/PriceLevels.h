@@ -0,0 +1,286 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include "Order.h"
+#include "OrderPool.h"
+
+// Containers holding the price levels of one side of the order book, keyed by price in ticks.
+// Both expose the same small interface so the order book can be built on top of either of them:
+//   find(tick)         -> pointer to the level at that price, nullptr if there is none
+//   insert(tick)       -> level at that price, created empty if it doesn't exist yet
+//   erase(tick)        -> remove the level at that price
+//   size()             -> number of price levels
+//   forEachLevel(f)    -> call f(tick, level) from the best price to the worst one, stops when f returns false
+
+// Price levels stored in a std::map (red-black tree), sorted with the side comparator
+// The tree nodes are recycled by a PoolAllocator instead of going back to the heap when a level is erased
+template <typename Compare>
+class MapPriceLevels
+{
+private:
+    std::map<int64_t, PriceLevel, Compare, PoolAllocator<std::pair<const int64_t, PriceLevel>>> levels;
+
+public:
+    PriceLevel* find(int64_t tick) {
+        auto it = levels.find(tick);
+        return it != levels.end() ? &it->second : nullptr;
+    }
+
+    PriceLevel& insert(int64_t tick) {
+        return levels[tick];
+    }
+
+    void erase(int64_t tick) {
+        levels.erase(tick);
+    }
+
+    size_t size() const {
+        return levels.size();
+    }
+
+    template <typename Visitor>
+    void forEachLevel(Visitor visit) {
+        for (auto& level : levels) {
+            if (!visit(level.first, level.second)) {
+                break;
+            }
+        }
+    }
+};
+
+// Price levels stored in a contiguous array indexed by the tick offset from a base price.
+// Finding a level is a subtraction and an array access, and the best price is tracked so the top of the book is O(1).
+// The array grows (and the base moves) when an order arrives outside of the prices it currently covers, up to
+// MAX_LADDER_SIZE ticks. A price too far from the resting levels for that (an outlier such as a mistyped 1000000.00 in a
+// book around 107.00) goes to a sparse overflow map instead of growing the array to cover the ticks in between.
+template <typename Compare>
+class LadderPriceLevels
+{
+private:
+    static constexpr size_t INITIAL_LADDER_SIZE = 4096; // number of ticks covered by the first allocation
+    static constexpr size_t MAX_LADDER_SIZE = size_t(1) << 20; // largest window (17 bytes per tick, about 18 MB per side)
+    // Direction to walk in to go from the best price towards worse prices (down for bids, up for asks)
+    static constexpr int64_t TOWARDS_WORSE = Compare()(1, 0) ? -1 : 1;
+
+    std::vector<PriceLevel> levels; // levels[i] is the price level at tick baseTick + i
+    std::vector<uint8_t> occupied; // occupied[i] is 1 if there is a price level at tick baseTick + i
+    int64_t baseTick = 0;
+    int64_t bestTick = 0;
+    size_t levelCount = 0; // levels in the array
+
+    // Levels outside of the window, best price first. Never holds a tick the window covers: the levels it holds are moved
+    // to the array when the window moves over them.
+    std::map<int64_t, PriceLevel, Compare, PoolAllocator<std::pair<const int64_t, PriceLevel>>> overflow;
+
+    bool inRange(int64_t tick) const {
+        return tick >= baseTick && tick < baseTick + static_cast<int64_t>(levels.size());
+    }
+
+    // Mark the array level at that tick as used
+    PriceLevel& occupy(int64_t tick) {
+        size_t offset = static_cast<size_t>(tick - baseTick);
+        if (!occupied[offset]) {
+            occupied[offset] = 1;
+            if (levelCount == 0 || Compare()(tick, bestTick)) {
+                bestTick = tick;
+            }
+            ++levelCount;
+        }
+        return levels[offset];
+    }
+
+    // Move the overflow levels the window covers now into the array
+    void takeOverflowLevels() {
+        for (auto it = overflow.begin(); it != overflow.end();) {
+            if (inRange(it->first)) {
+                occupy(it->first) = it->second;
+                it = overflow.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    // Make sure the ladder covers the given tick, moving the existing levels if the array has to be reallocated
+    // Returns false if the window would grow past MAX_LADDER_SIZE to cover it (the window is left as it is)
+    bool cover(int64_t tick) {
+        if (levels.empty()) {
+            levels.resize(INITIAL_LADDER_SIZE);
+            occupied.resize(INITIAL_LADDER_SIZE);
+            baseTick = tick - static_cast<int64_t>(INITIAL_LADDER_SIZE / 2);
+            return true;
+        }
+        if (levelCount == 0) {
+            // Nothing is resting in the array, so the window can simply be centered on the new price
+            baseTick = tick - static_cast<int64_t>(levels.size() / 2);
+            takeOverflowLevels();
+            return true;
+        }
+
+        // Ticks from the window to the new price, in unsigned arithmetic so a far outlier can't overflow
+        uint64_t distance = tick < baseTick ? static_cast<uint64_t>(baseTick) - static_cast<uint64_t>(tick)
+                                            : static_cast<uint64_t>(tick) - static_cast<uint64_t>(baseTick);
+        if (distance >= MAX_LADDER_SIZE) {
+            return false;
+        }
+        int64_t low = std::min(baseTick, tick);
+        int64_t high = std::max(baseTick + static_cast<int64_t>(levels.size()), tick + 1);
+        size_t span = static_cast<size_t>(high - low);
+        if (span > MAX_LADDER_SIZE) {
+            return false;
+        }
+        size_t newSize = std::min(std::max(levels.size() * 2, span * 2), MAX_LADDER_SIZE);
+        int64_t newBase = low - static_cast<int64_t>((newSize - span) / 2);
+
+        std::vector<PriceLevel> newLevels(newSize);
+        std::vector<uint8_t> newOccupied(newSize);
+        for (size_t i = 0; i < levels.size(); ++i) {
+            if (occupied[i]) {
+                size_t newOffset = static_cast<size_t>(baseTick + static_cast<int64_t>(i) - newBase);
+                // A level only holds the handles of its orders, they don't move
+                newLevels[newOffset] = levels[i];
+                newOccupied[newOffset] = 1;
+            }
+        }
+        levels.swap(newLevels);
+        occupied.swap(newOccupied);
+        baseTick = newBase;
+        if (!overflow.empty()) {
+            takeOverflowLevels();
+        }
+        return true;
+    }
+
+public:
+    PriceLevel* find(int64_t tick) {
+        if (!inRange(tick)) {
+            if (overflow.empty()) {
+                return nullptr;
+            }
+            auto it = overflow.find(tick);
+            return it != overflow.end() ? &it->second : nullptr;
+        }
+        if (!occupied[tick - baseTick]) {
+            return nullptr;
+        }
+        return &levels[tick - baseTick];
+    }
+
+    PriceLevel& insert(int64_t tick) {
+        if (!inRange(tick) && !cover(tick)) {
+            return overflow[tick];
+        }
+        return occupy(tick);
+    }
+
+    void erase(int64_t tick) {
+        if (!inRange(tick)) {
+            overflow.erase(tick);
+            return;
+        }
+        if (!occupied[tick - baseTick]) {
+            return;
+        }
+        size_t offset = static_cast<size_t>(tick - baseTick);
+        occupied[offset] = 0;
+        levels[offset] = PriceLevel();
+        --levelCount;
+
+        // If the best price was removed, walk towards worse prices until the next level
+        if (levelCount > 0 && tick == bestTick) {
+            do {
+                bestTick += TOWARDS_WORSE;
+            } while (!occupied[bestTick - baseTick]);
+        }
+    }
+
+    size_t size() const {
+        return levelCount + overflow.size();
+    }
+
+    template <typename Visitor>
+    void forEachLevel(Visitor visit) {
+        // Each overflow level is better or worse than the whole window: the better ones come first, then the window, then the worse ones
+        auto outside = overflow.begin();
+        for (; outside != overflow.end() && Compare()(outside->first, baseTick); ++outside) {
+            if (!visit(outside->first, outside->second)) {
+                return;
+            }
+        }
+        size_t visited = 0;
+        for (int64_t tick = bestTick; visited < levelCount; tick += TOWARDS_WORSE) {
+            size_t offset = static_cast<size_t>(tick - baseTick);
+            if (occupied[offset]) {
+                ++visited;
+                if (!visit(tick, levels[offset])) {
+                    return;
+                }
+            }
+        }
+        for (; outside != overflow.end(); ++outside) {
+            if (!visit(outside->first, outside->second)) {
+                return;
+            }
+        }
+    }
+};
+
+// Price levels stored in a vector sorted from the worst price to the best one, for books holding few orders.
+// No tree node per level and no window of empty ticks: a level is its price and its PriceLevel next to the others, which
+// matters when one process holds thousands of small books. The levels near the top of the book are at the back of the
+// vector, so adding or removing them only moves the few levels better than them; a level deep in a large book moves
+// every better level, the map or the ladder suit those books better.
+// A level can move when another one is inserted or erased, the book only keeps a reference to it within one event.
+template <typename Compare>
+class FlatPriceLevels
+{
+private:
+    std::vector<std::pair<int64_t, PriceLevel>> levels; // worst price first, best price last
+
+    // First level at that price or a better one
+    typename std::vector<std::pair<int64_t, PriceLevel>>::iterator lowerBound(int64_t tick) {
+        return std::lower_bound(levels.begin(), levels.end(), tick, [](const std::pair<int64_t, PriceLevel>& level, int64_t value) {
+            return Compare()(value, level.first);
+        });
+    }
+
+public:
+    PriceLevel* find(int64_t tick) {
+        auto it = lowerBound(tick);
+        return it != levels.end() && it->first == tick ? &it->second : nullptr;
+    }
+
+    PriceLevel& insert(int64_t tick) {
+        auto it = lowerBound(tick);
+        if (it == levels.end() || it->first != tick) {
+            it = levels.insert(it, { tick, PriceLevel() });
+        }
+        return it->second;
+    }
+
+    void erase(int64_t tick) {
+        auto it = lowerBound(tick);
+        if (it != levels.end() && it->first == tick) {
+            levels.erase(it);
+        }
+    }
+
+    size_t size() const {
+        return levels.size();
+    }
+
+    template <typename Visitor>
+    void forEachLevel(Visitor visit) {
+        for (auto it = levels.rbegin(); it != levels.rend(); ++it) {
+            if (!visit(it->first, it->second)) {
+                break;
+            }
+        }
+    }
+};
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include "Order.h"
+
+// Delta encoded snapshots (SnapshotFormat::Delta): consecutive snapshots of a book are mostly identical or differ in a single
+// level, so a record only holds the levels inserted, removed or changed in quantity since the previous snapshot written.
+//  - a snapshot identical to the previous one isn't written at all (the book at any time is the last record at or before it)
+//  - every DELTA_KEYFRAME_INTERVAL records a keyframe holds the full top N, decoding can start at any keyframe
+// Records (after a SnapshotFileHeader with the SNAPSHOT_DELTA_MAGIC magic, see SnapshotWriter.h):
+//   keyframe: byte 0, int64 timestamp, varint bid count, varint ask count, then for each bid and each ask (best first)
+//             the zigzag varint price change from the previous price and the varint quantity
+//   delta:    byte 1, zigzag varint timestamp change from the previous record, varint change count, then for each change
+//             varint (zigzag price change from the previous price << 2 | side << 1 | removed) and the varint quantity unless removed
+// Prices are in ticks, the previous price is 0 at the start of a keyframe and follows every price written.
+
+constexpr char SNAPSHOT_DELTA_MAGIC[8] = { 'O', 'B', 'D', 'E', 'L', 'T', 'A', '1' };
+constexpr size_t DELTA_KEYFRAME_INTERVAL = 1000;
+
+constexpr uint8_t DELTA_KEYFRAME = 0;
+constexpr uint8_t DELTA_CHANGES = 1;
+
+// Longest varint of a 64 bit value
+constexpr size_t MAX_VARINT_SIZE = 10;
+
+inline uint64_t zigzagEncode(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t zigzagDecode(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// 7 bits per byte, low bits first, the high bit of a byte is set if more bytes follow
+inline void writeVarint(char*& out, uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = static_cast<char>(value);
+}
+
+// Returns false if the varint doesn't end before end
+inline bool readVarint(const char*& in, const char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; in < end && shift < 64; shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(*in++);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+class SnapshotDeltaEncoder
+{
+private:
+    std::vector<DepthLevel> previousBids;
+    std::vector<DepthLevel> previousAsks;
+    std::vector<char> changes; // changes of the record being encoded, copied after their count
+    int64_t previousTimestamp = 0;
+    int64_t previousPrice = 0;
+    size_t keyframeInterval;
+    size_t recordsSinceKeyframe = 0;
+    bool started = false;
+
+    void writeLevelChange(char*& out, int side, bool removed, const DepthLevel& level) {
+        uint64_t priceChange = zigzagEncode(level.price - previousPrice);
+        writeVarint(out, priceChange << 2 | static_cast<uint64_t>(side) << 1 | (removed ? 1 : 0));
+        if (!removed) {
+            writeVarint(out, static_cast<uint64_t>(level.quantity));
+        }
+        previousPrice = level.price;
+    }
+
+    // Walk the previous and the new levels of one side together (both best first) and write what differs
+    template <typename Compare>
+    size_t writeSideChanges(char*& out, int side, const std::vector<DepthLevel>& previous, const DepthLevel* levels, size_t count) {
+        size_t changeCount = 0;
+        size_t i = 0;
+        size_t j = 0;
+        while (i < previous.size() || j < count) {
+            if (j == count || (i < previous.size() && Compare()(previous[i].price, levels[j].price))) {
+                writeLevelChange(out, side, true, previous[i++]); // not in the top N anymore
+                ++changeCount;
+            }
+            else if (i == previous.size() || Compare()(levels[j].price, previous[i].price)) {
+                writeLevelChange(out, side, false, levels[j++]); // new in the top N
+                ++changeCount;
+            }
+            else {
+                if (previous[i].quantity != levels[j].quantity) {
+                    writeLevelChange(out, side, false, levels[j]);
+                    ++changeCount;
+                }
+                ++i;
+                ++j;
+            }
+        }
+        return changeCount;
+    }
+
+public:
+    explicit SnapshotDeltaEncoder(size_t keyframeInterval = DELTA_KEYFRAME_INTERVAL) : keyframeInterval(std::max<size_t>(keyframeInterval, 1)) {
+    }
+
+    // Upper bound of the size of the next record with that many levels
+    size_t maxRecordSize(size_t bidCount, size_t askCount) const {
+        size_t levelCount = bidCount + askCount + previousBids.size() + previousAsks.size();
+        return 1 + 3 * MAX_VARINT_SIZE + levelCount * 2 * MAX_VARINT_SIZE;
+    }
+
+    // Encode a snapshot (both sides best first) at out, which has room for maxRecordSize bytes
+    // Returns the size of the record, 0 if the snapshot is the same as the previous one (nothing is written)
+    size_t encode(int64_t timestamp, const DepthLevel* bids, size_t bidCount, const DepthLevel* asks, size_t askCount, char* out) {
+        char* start = out;
+        size_t changeCount = 0;
+        char* changesEnd = nullptr;
+        if (started) {
+            changes.resize(maxRecordSize(bidCount, askCount));
+            changesEnd = changes.data();
+            changeCount = writeSideChanges<CompareBids>(changesEnd, 0, previousBids, bids, bidCount);
+            changeCount += writeSideChanges<CompareAsks>(changesEnd, 1, previousAsks, asks, askCount);
+            if (changeCount == 0) {
+                return 0;
+            }
+            // When a keyframe is due these changes are dropped, it starts over from the price 0
+        }
+        if (!started || recordsSinceKeyframe >= keyframeInterval) {
+            *out++ = static_cast<char>(DELTA_KEYFRAME);
+            std::memcpy(out, &timestamp, sizeof(timestamp));
+            out += sizeof(timestamp);
+            writeVarint(out, bidCount);
+            writeVarint(out, askCount);
+            previousPrice = 0;
+            for (size_t i = 0; i < bidCount + askCount; ++i) {
+                const DepthLevel& level = i < bidCount ? bids[i] : asks[i - bidCount];
+                writeVarint(out, zigzagEncode(level.price - previousPrice));
+                writeVarint(out, static_cast<uint64_t>(level.quantity));
+                previousPrice = level.price;
+            }
+            started = true;
+            recordsSinceKeyframe = 0;
+        }
+        else {
+            *out++ = static_cast<char>(DELTA_CHANGES);
+            writeVarint(out, zigzagEncode(timestamp - previousTimestamp));
+            writeVarint(out, changeCount);
+            size_t changesSize = static_cast<size_t>(changesEnd - changes.data());
+            std::memcpy(out, changes.data(), changesSize);
+            out += changesSize;
+        }
+        previousBids.assign(bids, bids + bidCount);
+        previousAsks.assign(asks, asks + askCount);
+        previousTimestamp = timestamp;
+        ++recordsSinceKeyframe;
+        return static_cast<size_t>(out - start);
+    }
+};
+
+// Rebuilds the full snapshots from the records, one record at a time
+class SnapshotDeltaDecoder
+{
+private:
+    std::vector<DepthLevel> bids;
+    std::vector<DepthLevel> asks;
+    int64_t timestamp = 0;
+    int64_t previousPrice = 0;
+    bool started = false;
+
+    template <typename Compare>
+    static void applyChange(std::vector<DepthLevel>& levels, int64_t price, bool removed, int quantity) {
+        auto position = std::lower_bound(levels.begin(), levels.end(), price, [](const DepthLevel& level, int64_t value) {
+            return Compare()(level.price, value);
+        });
+        bool found = position != levels.end() && position->price == price;
+        if (removed) {
+            if (found) {
+                levels.erase(position);
+            }
+        }
+        else if (found) {
+            position->quantity = quantity;
+        }
+        else {
+            levels.insert(position, { price, quantity });
+        }
+    }
+
+public:
+    // Decode the record starting at data (end is the end of the records), returns the start of the next record,
+    // nullptr if the record is truncated or a delta comes before the first keyframe
+    const char* decode(const char* data, const char* end) {
+        if (data >= end) {
+            return nullptr;
+        }
+        uint8_t type = static_cast<uint8_t>(*data++);
+        uint64_t value = 0;
+        if (type == DELTA_KEYFRAME) {
+            uint64_t bidCount = 0;
+            uint64_t askCount = 0;
+            if (end - data < static_cast<ptrdiff_t>(sizeof(timestamp))) {
+                return nullptr;
+            }
+            std::memcpy(&timestamp, data, sizeof(timestamp));
+            data += sizeof(timestamp);
+            if (!readVarint(data, end, bidCount) || !readVarint(data, end, askCount)) {
+                return nullptr;
+            }
+            bids.clear();
+            asks.clear();
+            previousPrice = 0;
+            for (uint64_t i = 0; i < bidCount + askCount; ++i) {
+                if (!readVarint(data, end, value)) {
+                    return nullptr;
+                }
+                previousPrice += zigzagDecode(value);
+                if (!readVarint(data, end, value)) {
+                    return nullptr;
+                }
+                (i < bidCount ? bids : asks).push_back({ previousPrice, static_cast<int>(value) });
+            }
+            started = true;
+            return data;
+        }
+        if (type != DELTA_CHANGES || !started) {
+            return nullptr;
+        }
+        uint64_t changeCount = 0;
+        if (!readVarint(data, end, value) || !readVarint(data, end, changeCount)) {
+            return nullptr;
+        }
+        timestamp += zigzagDecode(value);
+        for (uint64_t i = 0; i < changeCount; ++i) {
+            if (!readVarint(data, end, value)) {
+                return nullptr;
+            }
+            bool removed = (value & 1) != 0;
+            bool ask = (value & 2) != 0;
+            previousPrice += zigzagDecode(value >> 2);
+            uint64_t quantity = 0;
+            if (!removed && !readVarint(data, end, quantity)) {
+                return nullptr;
+            }
+            if (ask) {
+                applyChange<CompareAsks>(asks, previousPrice, removed, static_cast<int>(quantity));
+            }
+            else {
+                applyChange<CompareBids>(bids, previousPrice, removed, static_cast<int>(quantity));
+            }
+        }
+        return data;
+    }
+
+    int64_t getTimestamp() const {
+        return timestamp;
+    }
+
+    // Levels of the last decoded snapshot, best first
+    const std::vector<DepthLevel>& getBids() const {
+        return bids;
+    }
+
+    const std::vector<DepthLevel>& getAsks() const {
+        return asks;
+    }
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+// Sampling mode: instead of a snapshot after every event, one snapshot at every point of a fixed time grid
+// (start, start + interval, start + 2 x interval, ... up to end). The snapshot at a grid point is the book after the last event
+// at or before it, so a burst of events inside an interval only costs the book updates and a single snapshot is formatted
+// for it. A grid point is taken once an event (or a line of another symbol) after it is read: the book is still as it was at
+// that point. A gap longer than the interval gives the same book at every grid point inside it.
+class SnapshotGrid
+{
+private:
+    int64_t nextPoint = 0;
+    int64_t endTime = 0;
+    int64_t interval = 0;
+    bool finished = true;
+
+public:
+    SnapshotGrid() = default;
+
+    // An interval of 0 (or less) disables the sampling
+    SnapshotGrid(int64_t startTime, int64_t endTime, int64_t interval)
+        : nextPoint(startTime), endTime(endTime), interval(interval), finished(interval <= 0 || startTime > endTime) {
+    }
+
+    bool enabled() const {
+        return interval > 0;
+    }
+
+    // Call take(point) for every grid point up to that timestamp (included) not taken yet, in order
+    template <typename Take>
+    void takeUntil(int64_t timestamp, Take take) {
+        while (!finished && nextPoint <= timestamp) {
+            take(nextPoint);
+            if (endTime - nextPoint < interval) {
+                finished = true; // the next point would be after the end time
+            }
+            else {
+                nextPoint += interval;
+            }
+        }
+    }
+};
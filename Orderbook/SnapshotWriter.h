@@ -0,0 +1,335 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+#include "Order.h"
+#include "BookAnalytics.h"
+#include "SnapshotDelta.h"
+
+enum class SnapshotFormat {
+    Text, // SYMBOL, timestamp, q@p ... X q@p ...   (one line per snapshot, same layout as before, see SnapshotWriter::write for the analytics columns)
+    Binary, // SnapshotFileHeader, then for each snapshot: timestamp, bid count, ask count, levels (see SnapshotWriter::write)
+    Delta // SnapshotFileHeader, then keyframes and the levels changed since the previous snapshot (see SnapshotDelta.h)
+};
+
+inline const char* snapshotFileExtension(SnapshotFormat format) {
+    switch (format) {
+    case SnapshotFormat::Binary:
+        return ".bin";
+    case SnapshotFormat::Delta:
+        return ".delta";
+    default:
+        return ".txt";
+    }
+}
+
+constexpr char SNAPSHOT_FILE_MAGIC[8] = { 'O', 'B', 'S', 'N', 'A', 'P', 'S', '1' };
+constexpr uint32_t SNAPSHOT_FILE_VERSION = 1;
+
+// Flags of the header
+constexpr uint32_t SNAPSHOT_FLAG_ANALYTICS = 1; // every record ends with the analytics columns
+
+struct SnapshotFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags; // 0 for the files written before the flags (the field was reserved)
+    int64_t ticksPerUnit; // prices of the levels are in ticks
+    char symbol[32]; // null terminated
+};
+
+// Writes snapshots to a file as they are taken instead of keeping them in memory until the end.
+// The records are formatted (std::to_chars, no stream, no allocation) into a buffer that is written to the file when full.
+// The buffer starts small and doubles each time it fills up until it reaches the size given to the writer, so a writer
+// getting few snapshots (one per symbol in the all-symbols mode) stays small and a busy one ends up with the large buffer.
+class SnapshotWriter
+{
+public:
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 1 << 20;
+
+private:
+    static constexpr size_t INITIAL_BUFFER_SIZE = 1024;
+    // Upper bound of the text size of one level: quantity, '@', price, separator
+    static constexpr size_t MAX_LEVEL_SIZE = 48;
+    // Upper bound of the text size of the analytics columns
+    static constexpr size_t MAX_ANALYTICS_SIZE = 160;
+
+    std::string fileName;
+    std::ofstream file;
+    // Without keepFileOpen the file is only open while a flush writes to it (created by the first flush), so thousands of
+    // writers don't hold thousands of file descriptors
+    bool keepFileOpen;
+    bool created = false;
+    SnapshotFormat format;
+    bool analyticsColumns;
+    SnapshotDeltaEncoder deltaEncoder;
+    std::vector<char> buffer;
+    size_t maxBufferSize;
+    size_t used = 0;
+    uint64_t recordsWritten = 0;
+
+    // Open the file for a flush: created (truncated) the first time, appended to afterwards
+    bool openFile() {
+        if (!file.is_open()) {
+            std::ios::openmode mode = std::ios::out;
+            if (format != SnapshotFormat::Text) {
+                mode |= std::ios::binary;
+            }
+            if (created) {
+                mode |= std::ios::app;
+            }
+            file.open(fileName, mode);
+            if (!file.is_open()) {
+                if (!created) {
+                    std::cerr << "Unable to open file for writing!" << std::endl;
+                }
+                created = true; // reported once, the next flushes try to append
+                return false;
+            }
+            created = true;
+        }
+        return true;
+    }
+
+    void ensureSpace(size_t size) {
+        if (buffer.size() - used >= size) {
+            return;
+        }
+        size_t grown = std::min(buffer.size() * 2, maxBufferSize);
+        if (grown > buffer.size() && grown - used >= size) {
+            buffer.resize(grown);
+            return;
+        }
+        flush();
+        if (buffer.size() < size) {
+            buffer.resize(size);
+        }
+    }
+
+    void append(std::string_view text) {
+        std::memcpy(buffer.data() + used, text.data(), text.size());
+        used += text.size();
+    }
+
+    template <typename Integer>
+    void appendInteger(Integer value) {
+        auto result = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), value);
+        used = static_cast<size_t>(result.ptr - buffer.data());
+    }
+
+    // Same text as std::setprecision(5) on a stream
+    void appendPrice(int64_t ticks) {
+        // Fast path: with at most 5 digits in the number of ticks nothing is rounded and no exponent is used,
+        // the price is written with integer arithmetic only (units, then the decimals without the trailing zeros)
+        if (ticks >= 0 && ticks < 100000 && PRICE_DECIMALS <= 4) {
+            appendInteger(ticks / TICKS_PER_UNIT);
+            int64_t fraction = ticks % TICKS_PER_UNIT;
+            if (fraction != 0) {
+                char digits[PRICE_DECIMALS + 1];
+                int length = PRICE_DECIMALS;
+                for (int i = PRICE_DECIMALS - 1; i >= 0; --i) {
+                    digits[i] = static_cast<char>('0' + fraction % 10);
+                    fraction /= 10;
+                }
+                while (digits[length - 1] == '0') {
+                    --length;
+                }
+                buffer[used++] = '.';
+                append(std::string_view(digits, static_cast<size_t>(length)));
+            }
+            return;
+        }
+        auto result = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), ticksToPrice(ticks), std::chars_format::general, 5);
+        used = static_cast<size_t>(result.ptr - buffer.data());
+    }
+
+    // Analytics value with a fixed number of decimals (at most 8), "-" if the book doesn't have it
+    // Rounded to an integer number of the last decimal and written with integer arithmetic, std::to_chars of a double in fixed
+    // notation costs several times more
+    void appendDecimal(bool available, double value, int decimals) {
+        static constexpr int64_t POWERS_OF_TEN[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+        if (!available) {
+            append("-");
+            return;
+        }
+        int64_t scale = POWERS_OF_TEN[decimals];
+        double scaled = std::round(value * static_cast<double>(scale));
+        if (!(std::fabs(scaled) < 1e18)) {
+            auto result = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), value, std::chars_format::fixed, decimals);
+            used = static_cast<size_t>(result.ptr - buffer.data());
+            return;
+        }
+        int64_t units = static_cast<int64_t>(scaled);
+        if (units < 0) {
+            buffer[used++] = '-';
+            units = -units;
+        }
+        appendInteger(units / scale);
+        buffer[used++] = '.';
+        int64_t fraction = units % scale;
+        for (int i = decimals - 1; i >= 0; --i) {
+            buffer[used + i] = static_cast<char>('0' + fraction % 10);
+            fraction /= 10;
+        }
+        used += static_cast<size_t>(decimals);
+    }
+
+    template <typename Value>
+    void appendRaw(const Value& value) {
+        std::memcpy(buffer.data() + used, &value, sizeof(value));
+        used += sizeof(value);
+    }
+
+public:
+    // With analyticsColumns every snapshot also gets the analytics of the book (see write), the other snapshots are unchanged
+    // (the delta format has no analytics columns)
+    // bufferSize is the largest the buffer grows to, keepFileOpen=false only opens the file while flushing (see keepFileOpen)
+    SnapshotWriter(const std::string& fileName, const std::string& symbol, SnapshotFormat format = SnapshotFormat::Text, size_t bufferSize = DEFAULT_BUFFER_SIZE,
+                   bool analyticsColumns = false, bool keepFileOpen = true)
+        : fileName(fileName), keepFileOpen(keepFileOpen), format(format), analyticsColumns(analyticsColumns && format != SnapshotFormat::Delta),
+          buffer(std::min(bufferSize, INITIAL_BUFFER_SIZE)), maxBufferSize(std::max<size_t>(bufferSize, 1)) {
+        if (keepFileOpen && !openFile()) {
+            return;
+        }
+        if (format != SnapshotFormat::Text) {
+            // The header goes through the buffer like the records, a lazily opened file gets it with the first flush
+            SnapshotFileHeader header = {};
+            std::memcpy(header.magic, format == SnapshotFormat::Delta ? SNAPSHOT_DELTA_MAGIC : SNAPSHOT_FILE_MAGIC, sizeof(header.magic));
+            header.version = SNAPSHOT_FILE_VERSION;
+            header.flags = this->analyticsColumns ? SNAPSHOT_FLAG_ANALYTICS : 0;
+            header.ticksPerUnit = TICKS_PER_UNIT;
+            std::memcpy(header.symbol, symbol.data(), std::min(symbol.size(), sizeof(header.symbol) - 1));
+            ensureSpace(sizeof(header));
+            appendRaw(header);
+        }
+    }
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    ~SnapshotWriter() {
+        flush();
+    }
+
+    // Write one snapshot, both sides are given best price first
+    // Text: the bids are written from the worst to the best price, the asks from the best to the worst price
+    // Binary: int64 timestamp, uint8 bid count, uint8 ask count, then (int64 price, int32 quantity) for each bid and ask, best first
+    // Analytics columns (if the writer has them):
+    // Text: ", mid, microprice, imbalance, bid VWAP, ask VWAP" at the end of the line, "-" for the values the book doesn't have
+    // Binary: double mid, microprice, imbalance, bid VWAP, ask VWAP after the levels, prices in ticks, NaN for the values the book doesn't have
+    void write(int64_t timestamp, std::string_view symbol, const std::vector<DepthLevel>& bidLevels, const std::vector<DepthLevel>& askLevels) {
+        write(timestamp, symbol, bidLevels.data(), bidLevels.size(), askLevels.data(), askLevels.size());
+    }
+
+    // Same with the levels given as arrays (the pipelined replay keeps the levels of many snapshots in one vector, see Pipeline.h)
+    // Delta: the snapshot is skipped if it is the same as the previous one, otherwise encoded by SnapshotDeltaEncoder
+    // analytics is only used if the writer has the analytics columns (values missing if it is nullptr)
+    void write(int64_t timestamp, std::string_view symbol, const DepthLevel* bidLevels, size_t bidCount, const DepthLevel* askLevels, size_t askCount,
+               const BookAnalytics* analytics = nullptr) {
+        size_t levelCount = bidCount + askCount;
+        BookAnalytics missing;
+        if (analytics == nullptr) {
+            analytics = &missing;
+        }
+        if (format == SnapshotFormat::Delta) {
+            ensureSpace(deltaEncoder.maxRecordSize(bidCount, askCount));
+            size_t recordSize = deltaEncoder.encode(timestamp, bidLevels, bidCount, askLevels, askCount, buffer.data() + used);
+            if (recordSize == 0) {
+                return;
+            }
+            used += recordSize;
+        }
+        else if (format == SnapshotFormat::Text) {
+            ensureSpace(symbol.size() + 32 + levelCount * MAX_LEVEL_SIZE + (analyticsColumns ? MAX_ANALYTICS_SIZE : 0));
+            append(symbol);
+            append(", ");
+            appendInteger(timestamp);
+            append(", ");
+            for (size_t i = bidCount; i > 0; --i) {
+                appendInteger(bidLevels[i - 1].quantity);
+                append("@");
+                appendPrice(bidLevels[i - 1].price);
+                append(" ");
+            }
+            append("X ");
+            for (size_t i = 0; i < askCount; ++i) {
+                appendInteger(askLevels[i].quantity);
+                append("@");
+                appendPrice(askLevels[i].price);
+                append("  ");
+            }
+            if (analyticsColumns) {
+                // Prices with two more decimals than the ticks (a mid can be half a tick, the weighted prices anything in between)
+                bool both = analytics->hasBid && analytics->hasAsk;
+                append(", ");
+                appendDecimal(both, analytics->mid / TICKS_PER_UNIT, PRICE_DECIMALS + 2);
+                append(", ");
+                appendDecimal(both, analytics->microprice / TICKS_PER_UNIT, PRICE_DECIMALS + 2);
+                append(", ");
+                appendDecimal(both, analytics->imbalance, 4);
+                append(", ");
+                appendDecimal(analytics->hasBid, analytics->bidVwap / TICKS_PER_UNIT, PRICE_DECIMALS + 2);
+                append(", ");
+                appendDecimal(analytics->hasAsk, analytics->askVwap / TICKS_PER_UNIT, PRICE_DECIMALS + 2);
+            }
+            append("\n");
+        }
+        else {
+            ensureSpace(sizeof(int64_t) + 2 + levelCount * (sizeof(int64_t) + sizeof(int32_t)) + (analyticsColumns ? 5 * sizeof(double) : 0));
+            appendRaw(timestamp);
+            appendRaw(static_cast<uint8_t>(std::min<size_t>(bidCount, UINT8_MAX)));
+            appendRaw(static_cast<uint8_t>(std::min<size_t>(askCount, UINT8_MAX)));
+            for (size_t i = 0; i < bidCount && i < UINT8_MAX; ++i) {
+                appendRaw(bidLevels[i].price);
+                appendRaw(static_cast<int32_t>(bidLevels[i].quantity));
+            }
+            for (size_t i = 0; i < askCount && i < UINT8_MAX; ++i) {
+                appendRaw(askLevels[i].price);
+                appendRaw(static_cast<int32_t>(askLevels[i].quantity));
+            }
+            if (analyticsColumns) {
+                bool both = analytics->hasBid && analytics->hasAsk;
+                double none = std::numeric_limits<double>::quiet_NaN();
+                appendRaw(both ? analytics->mid : none);
+                appendRaw(both ? analytics->microprice : none);
+                appendRaw(both ? analytics->imbalance : none);
+                appendRaw(analytics->hasBid ? analytics->bidVwap : none);
+                appendRaw(analytics->hasAsk ? analytics->askVwap : none);
+            }
+        }
+        recordsWritten++;
+    }
+
+    // Write the buffered records to the file (a writer that doesn't keep its file open creates it on its first flush,
+    // even without any record, and closes it again)
+    void flush() {
+        if (!keepFileOpen && (used > 0 || !created)) {
+            openFile();
+        }
+        if (used > 0 && file.is_open()) {
+            file.write(buffer.data(), static_cast<std::streamsize>(used));
+            file.flush();
+        }
+        used = 0;
+        if (!keepFileOpen && file.is_open()) {
+            file.close();
+        }
+    }
+
+    bool hasAnalyticsColumns() const {
+        return analyticsColumns;
+    }
+
+    uint64_t recordCount() const {
+        return recordsWritten;
+    }
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <deque>
+#include <unordered_map>
+
+// Gives every symbol (SCH, SCS, ...) a small integer id so orders can carry the id instead of a string
+class SymbolTable
+{
+private:
+    std::deque<std::string> names; // names[id] is the symbol with that id (a deque so the strings never move)
+    std::unordered_map<std::string_view, uint16_t> ids; // keys point into names, so looking a symbol up never allocates
+
+public:
+    static constexpr uint16_t NO_SYMBOL = UINT16_MAX;
+
+    // Return the id of the symbol, a new id is given the first time a symbol is seen
+    // Returns NO_SYMBOL for a new symbol once the table is full (NO_SYMBOL symbols), the ids never wrap around
+    uint16_t intern(std::string_view symbol) {
+        auto it = ids.find(symbol);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        if (full()) {
+            return NO_SYMBOL;
+        }
+        uint16_t id = static_cast<uint16_t>(names.size());
+        names.emplace_back(symbol);
+        ids.emplace(names.back(), id);
+        return id;
+    }
+
+    // Return the id of the symbol, or NO_SYMBOL if it was never seen
+    uint16_t find(std::string_view symbol) const {
+        auto it = ids.find(symbol);
+        return it != ids.end() ? it->second : NO_SYMBOL;
+    }
+
+    const std::string& name(uint16_t id) const {
+        return names[id];
+    }
+
+    size_t size() const {
+        return names.size();
+    }
+
+    // Every id is taken, a new symbol can't be added anymore
+    bool full() const {
+        return names.size() >= NO_SYMBOL;
+    }
+};
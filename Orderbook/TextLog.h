@@ -0,0 +1,205 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <charconv>
+#include <string>
+#include <string_view>
+
+#include "Order.h"
+#include "SymbolTable.h"
+#include "MappedFile.h"
+
+// Parsing of the text logs, one order per line: timestamp orderId symbol side category price quantity
+// The fields are parsed in place from the line (no std::string, no stream, no locale) so reading a log never allocates
+
+inline bool isLogWhitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Return the next whitespace separated token of the line and move the line past it, empty if there is none left
+inline std::string_view nextToken(std::string_view& line) {
+    size_t begin = 0;
+    while (begin < line.size() && isLogWhitespace(line[begin])) {
+        ++begin;
+    }
+    size_t end = begin;
+    while (end < line.size() && !isLogWhitespace(line[end])) {
+        ++end;
+    }
+    std::string_view token = line.substr(begin, end - begin);
+    line.remove_prefix(end);
+    return token;
+}
+
+template <typename Integer>
+inline bool parseInteger(std::string_view token, Integer& value) {
+    if (token.empty()) {
+        return false;
+    }
+    auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+    return result.ec == std::errc() && result.ptr == token.data() + token.size();
+}
+
+// Parse a decimal price straight into ticks
+// Prices with at most PRICE_DECIMALS decimals (all of them in practice) are parsed with integer arithmetic only,
+// anything else goes through strtod and priceToTicks so it is rounded exactly like before
+inline bool parsePriceTicks(std::string_view token, int64_t& ticks) {
+    size_t i = 0;
+    bool negative = !token.empty() && token[0] == '-';
+    if (negative) {
+        ++i;
+    }
+
+    int64_t units = 0;
+    size_t unitDigits = 0;
+    while (i < token.size() && token[i] >= '0' && token[i] <= '9' && unitDigits < 15) {
+        units = units * 10 + (token[i] - '0');
+        ++i;
+        ++unitDigits;
+    }
+    int64_t fraction = 0;
+    int fractionDigits = 0;
+    if (i < token.size() && token[i] == '.') {
+        ++i;
+        while (i < token.size() && token[i] >= '0' && token[i] <= '9' && fractionDigits < PRICE_DECIMALS) {
+            fraction = fraction * 10 + (token[i] - '0');
+            ++i;
+            ++fractionDigits;
+        }
+    }
+    if (i == token.size() && unitDigits + fractionDigits > 0) {
+        ticks = units * TICKS_PER_UNIT + fraction * powerOfTen(PRICE_DECIMALS - fractionDigits);
+        if (negative) {
+            ticks = -ticks;
+        }
+        return true;
+    }
+
+    // Slow path: more decimals than the tick size, exponent, sign, ...
+    char buffer[64];
+    if (token.empty() || token.size() >= sizeof(buffer)) {
+        return false;
+    }
+    std::memcpy(buffer, token.data(), token.size());
+    buffer[token.size()] = '\0';
+    char* end = nullptr;
+    double price = std::strtod(buffer, &end);
+    if (end != buffer + token.size() || !std::isfinite(price)) {
+        return false;
+    }
+    ticks = priceToTicks(price);
+    return true;
+}
+
+// Parse one line of the log
+// The price is converted to ticks and the symbol to its id here so the order book never deals with doubles or strings
+// Returns false if the line doesn't contain the 7 fields, or if its symbol is new and the symbol table is full
+// (the caller reports "Error reading line!" and skips it)
+inline bool parseOrderLine(std::string_view line, Order& order, SymbolTable& symbols) {
+    std::string_view timestamp = nextToken(line);
+    std::string_view orderId = nextToken(line);
+    std::string_view symbol = nextToken(line);
+    std::string_view side = nextToken(line);
+    std::string_view category = nextToken(line);
+    std::string_view price = nextToken(line);
+    std::string_view quantity = nextToken(line);
+
+    if (!parseInteger(timestamp, order.timestamp) || !parseInteger(orderId, order.orderId) || symbol.empty() || side.empty() || category.empty()
+        || !parsePriceTicks(price, order.price) || !parseInteger(quantity, order.quantity)) {
+        return false;
+    }
+    order.symbol = symbols.intern(symbol);
+    if (order.symbol == SymbolTable::NO_SYMBOL) {
+        return false;
+    }
+    order.side = parseSide(side);
+    order.category = parseCategory(category);
+    return true;
+}
+
+// Symbol field of a line (empty if the line is too short), a reader interested in one symbol can skip the other lines without parsing them
+inline std::string_view lineSymbol(std::string_view line) {
+    nextToken(line);
+    nextToken(line);
+    return nextToken(line);
+}
+
+// Same, also giving the timestamp field of the line (not parsed) from the same pass over the line
+inline std::string_view lineSymbol(std::string_view line, std::string_view& timestamp) {
+    timestamp = nextToken(line);
+    nextToken(line);
+    return nextToken(line);
+}
+
+// Tells if a timestamp field is after `time`, given with its digits too (std::to_string(time)). Checked on every line by the
+// readers that skip the lines of the other symbols, so they still stop at the end of a time range (the log is sorted by
+// timestamp). The field isn't parsed unless it looks after the time: a number with more digits than a positive time, or as many
+// and greater digit by digit, is after it.
+inline bool timestampAfter(std::string_view timestamp, int64_t time, std::string_view timeDigits) {
+    if (time >= 0 && (timestamp.size() < timeDigits.size() || (timestamp.size() == timeDigits.size() && timestamp.compare(timeDigits) <= 0))) {
+        return false;
+    }
+    int64_t value;
+    return parseInteger(timestamp, value) && value > time;
+}
+
+// Memory mapped text log, the lines are scanned in place without copying them
+class TextLogReader
+{
+private:
+    MappedFile file;
+    const char* cursor = nullptr;
+    const char* fileEnd = nullptr;
+    uint64_t linesRead = 0;
+
+public:
+    bool open(const std::string& filePath) {
+        if (!file.open(filePath)) {
+            return false;
+        }
+        cursor = file.data();
+        fileEnd = file.data() + file.size();
+        linesRead = 0;
+        return true;
+    }
+
+    // Get the next line (without its end of line), returns false at the end of the file
+    bool nextLine(std::string_view& line) {
+        if (cursor == fileEnd) {
+            return false;
+        }
+        const char* lineEnd = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<size_t>(fileEnd - cursor)));
+        if (lineEnd == nullptr) {
+            lineEnd = fileEnd; // last line without an end of line
+        }
+        line = std::string_view(cursor, static_cast<size_t>(lineEnd - cursor));
+        cursor = lineEnd == fileEnd ? fileEnd : lineEnd + 1;
+        ++linesRead;
+        return true;
+    }
+
+    // Byte offset of the next line in the file
+    size_t offset() const {
+        return static_cast<size_t>(cursor - file.data());
+    }
+
+    // Continue reading from that byte offset (the start of a line, as given by offset)
+    bool seek(size_t offset) {
+        if (offset > file.size()) {
+            return false;
+        }
+        cursor = file.data() + offset;
+        return true;
+    }
+
+    uint64_t lineCount() const {
+        return linesRead;
+    }
+
+    size_t size() const {
+        return file.size();
+    }
+};
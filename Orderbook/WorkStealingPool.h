@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <algorithm>
+
+// Pool of worker threads for independent tasks of very different lengths (see BatchReplay.h).
+// Every worker has its own FIFO of tasks and only takes from the others when its own is empty, so the tasks given to a
+// worker (and the ones it spawns) stay with it while it is busy, and an idle worker takes over the work left elsewhere.
+// A task can submit more tasks while it runs, run returns once every task, spawned ones included, is done.
+class WorkStealingPool
+{
+public:
+    // A task gets the pool (to submit more tasks) and the index of the worker running it
+    using Task = std::function<void(WorkStealingPool&, size_t)>;
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::atomic<size_t> queuedTasks{ 0 }; // in the queues, not started yet
+    std::atomic<size_t> unfinishedTasks{ 0 }; // submitted and not done yet
+    std::atomic<size_t> stolenTasks{ 0 };
+    std::mutex idleMutex;
+    std::condition_variable idle; // a task was submitted or the last one finished
+
+    // Next task of the worker: the front of its own queue, otherwise the front of the first other queue with a task
+    // (the front holds the tasks submitted first, the batch submits its largest jobs first)
+    bool take(size_t worker, Task& task) {
+        for (size_t i = 0; i < queues.size(); ++i) {
+            WorkerQueue& queue = *queues[(worker + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                queuedTasks--;
+                if (i != 0) {
+                    stolenTasks++;
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void work(size_t worker) {
+        Task task;
+        while (true) {
+            if (take(worker, task)) {
+                task(*this, worker);
+                task = nullptr;
+                if (--unfinishedTasks == 0) {
+                    std::lock_guard<std::mutex> lock(idleMutex);
+                    idle.notify_all();
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(idleMutex);
+            idle.wait(lock, [this] { return queuedTasks > 0 || unfinishedTasks == 0; });
+            if (queuedTasks == 0 && unfinishedTasks == 0) {
+                return;
+            }
+        }
+    }
+
+public:
+    explicit WorkStealingPool(size_t workerCount) {
+        workerCount = std::max<size_t>(workerCount, 1);
+        for (size_t worker = 0; worker < workerCount; ++worker) {
+            queues.push_back(std::make_unique<WorkerQueue>());
+        }
+    }
+
+    size_t workerCount() const {
+        return queues.size();
+    }
+
+    // Add a task at the back of the queue of that worker (a task running on a worker usually gives its own index)
+    void submit(Task task, size_t worker) {
+        unfinishedTasks++;
+        {
+            WorkerQueue& queue = *queues[worker % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+            queuedTasks++;
+        }
+        std::lock_guard<std::mutex> lock(idleMutex);
+        idle.notify_one();
+    }
+
+    // Run the tasks on the workers (the calling thread is worker 0) until every task is done
+    void run() {
+        std::vector<std::thread> workers;
+        for (size_t worker = 1; worker < queues.size(); ++worker) {
+            workers.emplace_back(&WorkStealingPool::work, this, worker);
+        }
+        work(0);
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Tasks a worker took from the queue of another worker
+    size_t stealCount() const {
+        return stolenTasks;
+    }
+};